@@ -0,0 +1,75 @@
+#include "Animation.h"
+
+//******
+//AnimationsInit
+//******
+void AnimationsInit(AnimationPool *pool, float framePeriod, int numFrames, int framesPerRow)
+{
+	pool->framePeriod  = framePeriod;
+	pool->numFrames    = numFrames;
+	pool->framesPerRow = framesPerRow;
+
+	AnimationsClear(pool);
+}
+
+//******
+//AnimationsClear
+//******
+void AnimationsClear(AnimationPool *pool)
+{
+	pool->count = 0;
+	pool->time  = 0.0f;
+}
+
+//******
+//AnimationsStart
+//******
+bool AnimationsStart(AnimationPool *pool, const Vec2 &pos)
+{
+	if (pool->count == MAX_ANIMATIONS) return false;
+
+	const int i = pool->count++;
+	pool->pos[i]       = pos;
+	pool->startTime[i] = pool->time;
+	return true;
+}
+
+//******
+//AnimationsUpdate
+//Animations end in the order they started, so the finished ones are all at the front.
+//******
+void AnimationsUpdate(AnimationPool *pool, float delta)
+{
+	pool->time += delta;
+
+	const float length = pool->framePeriod * pool->numFrames;
+
+	int finished = 0;
+	while (finished != pool->count && pool->time - pool->startTime[finished] >= length) ++finished;
+	if (finished == 0) return;
+
+	pool->count -= finished;
+	for (int i = 0; i != pool->count; ++i)
+	{
+		pool->pos[i]       = pool->pos[i + finished];
+		pool->startTime[i] = pool->startTime[i + finished];
+	}
+}
+
+//******
+//AnimationFrame
+//******
+int AnimationFrame(const AnimationPool *pool, int i)
+{
+	const int frame = (int)((pool->time - pool->startTime[i]) / pool->framePeriod);
+	return frame < pool->numFrames ? frame : pool->numFrames - 1;
+}
+
+//******
+//AnimationSheetFrame
+//******
+Vec2 AnimationSheetFrame(const AnimationPool *pool, int i)
+{
+	const int frame = AnimationFrame(pool, i);
+	return Vec2((float)(frame % pool->framesPerRow), (float)(frame / pool->framesPerRow));
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Vector.h"
+
+//******
+//ANIMATION
+//Sprite sheet animations that run once, only the running ones are stored.
+//The frame is worked out from the start time, nothing is counted down per animation.
+//******
+
+struct AnimationPool
+{
+#define MAX_ANIMATIONS 1024
+
+	Vec2  pos[MAX_ANIMATIONS];
+	float startTime[MAX_ANIMATIONS];
+	int   count;
+
+	float time;        //ms, advanced by AnimationsUpdate.
+	float framePeriod; //ms per frame.
+	int   numFrames;
+	int   framesPerRow; //In the sprite sheet.
+};
+
+void AnimationsInit(AnimationPool *pool, float framePeriod, int numFrames, int framesPerRow);
+
+void AnimationsClear(AnimationPool *pool);
+
+//Returns false if the pool is full, the animation is not started.
+bool AnimationsStart(AnimationPool *pool, const Vec2 &pos);
+
+//Advance time, finished animations are dropped.
+void AnimationsUpdate(AnimationPool *pool, float delta);
+
+//Frame of animation i, 0 to numFrames - 1.
+int AnimationFrame(const AnimationPool *pool, int i);
+
+//Column and row of the frame in the sprite sheet.
+Vec2 AnimationSheetFrame(const AnimationPool *pool, int i);
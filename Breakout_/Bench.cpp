@@ -0,0 +1,507 @@
+#include "Bench.h"
+#include "Simulation.h"
+#include "Collision.h"
+#include "Particles.h"
+#include "Jobs.h"
+#include "Effects.h"
+#include "Snapshot.h"
+#include "MemAlloc.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+typedef std::chrono::high_resolution_clock BenchClock;
+
+//******
+//ElapsedMs
+//******
+static double ElapsedMs(BenchClock::time_point from, BenchClock::time_point to)
+{
+	return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+//******
+//SpawnBenchBalls
+//Fill up with balls spread over the lower half of the window, falling in every direction.
+//******
+static void SpawnBenchBalls(SimState *s, int numBalls, Rng *rng)
+{
+	const RealVec2 maxVel = s->balls.maxVel;
+
+	while (s->balls.count < numBalls)
+	{
+		const unsigned int dirs = RngNext(rng);
+		const RealVec2 pos = RealVec2(RngInt(rng, WINDOW_WIDTH - BALL_WIDTH), WINDOW_HEIGHT / 2 + RngInt(rng, WINDOW_HEIGHT / 4));
+		const RealVec2 vel = RealVec2(dirs & 1 ? maxVel.x : -maxVel.x, dirs & 2 ? maxVel.y : -maxVel.y);
+		if (!SimSpawnBall(s, pos, vel)) break;
+	}
+}
+
+//******
+//BenchMultiBall
+//******
+bool BenchMultiBall(int numBalls, int ticks)
+{
+	SimState *s = DBG_NEW SimState();
+	SimInit(s);
+	SimStartLevel(s);
+	s->multiBall = true;
+
+	Rng rng;
+	RngSeed(&rng, 1, RNG_STREAM_BENCH);
+
+	//Ball 0 has to be in flight or the paddle holds it.
+	SimInput input;
+	input.moveDir  = 0;
+	input.fireBall = true;
+
+	double total = 0.0;
+	double worst = 0.0;
+	int    levels = 0;
+
+	for (int t = 0; t != ticks; ++t)
+	{
+		SpawnBenchBalls(s, numBalls, &rng);
+
+		//Paddle sweeps back and forth so balls keep bouncing off it.
+		input.moveDir = (t / 120) & 1 ? 1 : -1;
+
+		const BenchClock::time_point start = BenchClock::now();
+		const int events = SimStep(s, &input, NULL);
+		const double ms = ElapsedMs(start, BenchClock::now());
+
+		input.fireBall = false;
+
+		total += ms;
+		if (ms > worst) worst = ms;
+
+		//Keep the scene going, a fresh field when it is cleared or the blocks reached the paddle.
+		if (events & (SIM_EVENT_LEVEL_COMPLETED | SIM_EVENT_GAME_COMPLETED | SIM_EVENT_GAME_OVER))
+		{
+			SimStartLevel(s);
+			input.fireBall = true;
+			++levels;
+		}
+	}
+
+	const double budget = TIME_STEP;
+	printf("Multi-ball: %d balls, %d ticks, %d fields.\n", numBalls, ticks, levels);
+	printf("  avg tick %.4f ms, worst tick %.4f ms, budget %.2f ms.\n", total / ticks, worst, budget);
+	printf("  %.0f ticks/sec.\n", ticks / (total / 1000.0));
+
+	delete s;
+
+	return worst <= budget;
+}
+
+//******
+//BenchOverlap
+//******
+bool BenchOverlap(int numBoxes, int iterations)
+{
+	float *posX = DBG_NEW float[numBoxes];
+	float *posY = DBG_NEW float[numBoxes];
+
+	//Output, [0] scalar and [1] simd.
+	float *normalX[2], *normalY[2], *depth[2];
+	for (int k = 0; k != 2; ++k)
+	{
+		normalX[k] = DBG_NEW float[numBoxes];
+		normalY[k] = DBG_NEW float[numBoxes];
+		depth[k]   = DBG_NEW float[numBoxes];
+	}
+
+	//Boxes scattered over the window so some overlap boxA and some do not.
+	Rng rng;
+	RngSeed(&rng, 1, RNG_STREAM_BENCH);
+	for (int i = 0; i != numBoxes; ++i)
+	{
+		posX[i] = (float)RngInt(&rng, WINDOW_WIDTH * 4) * 0.25f;
+		posY[i] = (float)RngInt(&rng, WINDOW_HEIGHT * 4) * 0.25f;
+	}
+
+	const Vec2 size = Vec2(BLOCK_WIDTH, BLOCK_HEIGHT);
+
+	double ms[2] = { 0.0, 0.0 };
+	int    hits[2] = { 0, 0 };
+	bool   same = true;
+
+	for (int n = 0; n != iterations; ++n)
+	{
+		//boxA wanders over the window, same place for both paths.
+		const AxisBox boxA = { Vec2((float)((n * 37) % WINDOW_WIDTH), (float)((n * 23) % WINDOW_HEIGHT)), Vec2(BLOCK_WIDTH * 4, BLOCK_HEIGHT * 4) };
+
+		BenchClock::time_point start = BenchClock::now();
+		hits[0] += OverlapBoxesScalar(boxA, posX, posY, size, numBoxes, normalX[0], normalY[0], depth[0]);
+		ms[0] += ElapsedMs(start, BenchClock::now());
+
+		start = BenchClock::now();
+		hits[1] += OverlapBoxes(boxA, posX, posY, size, numBoxes, normalX[1], normalY[1], depth[1]);
+		ms[1] += ElapsedMs(start, BenchClock::now());
+
+		if (memcmp(normalX[0], normalX[1], numBoxes * sizeof(float)) != 0 ||
+			memcmp(normalY[0], normalY[1], numBoxes * sizeof(float)) != 0 ||
+			memcmp(depth[0], depth[1], numBoxes * sizeof(float)) != 0)
+		{
+			same = false;
+		}
+	}
+
+	const double tests = (double)numBoxes * iterations;
+	printf("Overlap: %d boxes, %d iterations, %d overlaps.\n", numBoxes, iterations, hits[0]);
+	printf("  scalar %.3f ns/box, simd %.3f ns/box, %.2fx.\n", ms[0] * 1e6 / tests, ms[1] * 1e6 / tests, ms[0] / ms[1]);
+	printf("  %s\n", same && hits[0] == hits[1] ? "Results match." : "Results DIFFER.");
+
+	for (int k = 0; k != 2; ++k)
+	{
+		delete[] normalX[k];
+		delete[] normalY[k];
+		delete[] depth[k];
+	}
+	delete[] posX;
+	delete[] posY;
+
+	return same && hits[0] == hits[1];
+}
+
+//******
+//SpawnBenchParticles
+//Same particles into every pool, debris thrown up from the lower half of the window.
+//******
+#define BENCH_PARTICLE_PATHS 3 //Scalar, simd, jobs.
+
+static void SpawnBenchParticles(ParticlePool **pools, int count, Rng *rng)
+{
+	while (pools[0]->count < count)
+	{
+		const Vec2 pos = Vec2(RngRange(rng, 2.0f, WINDOW_WIDTH - 4.0f), RngRange(rng, WINDOW_HEIGHT / 2, WINDOW_HEIGHT * 3 / 4));
+		const Vec2 vel = Vec2(RngRange(rng, -1.0f, 1.0f), RngRange(rng, -6.0f, 0.0f));
+		const Vec2 acc = Vec2(RngRange(rng, -0.8f, 0.8f), RngRange(rng, -0.8f, 0.8f));
+		const int color = RngInt(rng, BLOCK_TYPES);
+
+		if (!ParticlesSpawn(pools[0], pos, vel, acc, color)) break;
+		for (int k = 1; k != BENCH_PARTICLE_PATHS; ++k) ParticlesSpawn(pools[k], pos, vel, acc, color);
+	}
+}
+
+//******
+//BenchParticles
+//******
+bool BenchParticles(int count, int ticks, int threads)
+{
+	JobPool *jobs = DBG_NEW JobPool;
+	JobsInit(jobs, threads);
+
+	ParticlePool *pool[BENCH_PARTICLE_PATHS];
+	for (int k = 0; k != BENCH_PARTICLE_PATHS; ++k)
+	{
+		pool[k] = DBG_NEW ParticlePool;
+		ParticlesClear(pool[k]);
+	}
+
+	Rng rng;
+	RngSeed(&rng, 1, RNG_STREAM_BENCH);
+
+	double ms[BENCH_PARTICLE_PATHS]    = {};
+	double worst[BENCH_PARTICLE_PATHS] = {};
+	long long culled = 0;
+	bool same = true;
+
+	for (int t = 0; t != ticks; ++t)
+	{
+		SpawnBenchParticles(pool, count, &rng);
+		const int before = pool[0]->count;
+
+		for (int k = 0; k != BENCH_PARTICLE_PATHS; ++k)
+		{
+			const BenchClock::time_point start = BenchClock::now();
+			if (k == 0)      ParticlesUpdateScalar(pool[k], TIME_STEP);
+			else if (k == 1) ParticlesUpdate(pool[k], TIME_STEP);
+			else             ParticlesUpdateJobs(pool[k], TIME_STEP, jobs);
+			const double tickMs = ElapsedMs(start, BenchClock::now());
+
+			ms[k] += tickMs;
+			if (tickMs > worst[k]) worst[k] = tickMs;
+		}
+
+		culled += before - pool[0]->count;
+
+		const int n = pool[0]->count;
+		for (int k = 1; k != BENCH_PARTICLE_PATHS; ++k)
+		{
+			if (n != pool[k]->count ||
+				memcmp(pool[0]->posX, pool[k]->posX, n * sizeof(float)) != 0 ||
+				memcmp(pool[0]->posY, pool[k]->posY, n * sizeof(float)) != 0 ||
+				memcmp(pool[0]->velY, pool[k]->velY, n * sizeof(float)) != 0 ||
+				memcmp(pool[0]->color, pool[k]->color, n) != 0)
+			{
+				same = false;
+			}
+		}
+	}
+
+	const double updates = (double)count * ticks;
+	printf("Particles: %d particles, %d ticks, %lld left the window.\n", count, ticks, culled);
+	printf("  scalar %.3f ms/tick (worst %.3f), simd %.3f ms/tick (worst %.3f), %.2fx.\n", ms[0] / ticks, worst[0], ms[1] / ticks, worst[1], ms[0] / ms[1]);
+	printf("  %d threads %.3f ms/tick (worst %.3f), %.2fx over simd.\n", JobsThreads(jobs), ms[2] / ticks, worst[2], ms[1] / ms[2]);
+	printf("  scalar %.3f ns/particle, simd %.3f ns/particle, threads %.3f ns/particle.\n", ms[0] * 1e6 / updates, ms[1] * 1e6 / updates, ms[2] * 1e6 / updates);
+	printf("  %s\n", same ? "Results match." : "Results DIFFER.");
+
+	for (int k = 0; k != BENCH_PARTICLE_PATHS; ++k)
+	{
+		delete pool[k];
+	}
+	JobsFree(jobs);
+	delete jobs;
+
+	return same;
+}
+
+//******
+//BenchStartLevel
+//******
+bool BenchStartLevel(int levels)
+{
+	SimState     *s         = DBG_NEW SimState();
+	Effects      *fx        = DBG_NEW Effects;
+	SnapshotRing *snapshots = DBG_NEW SnapshotRing;
+
+	SimInit(s);
+	EffectsInit(fx);
+	SnapshotClear(snapshots);
+
+	double startMs = 0.0, startWorst = 0.0;
+	double hitMs   = 0.0, hitWorst   = 0.0;
+	int memoryAtStart = 0;
+
+	for (int n = 0; n != levels; ++n)
+	{
+		s->score.level = 1 + n % 3;
+
+		BenchClock::time_point start = BenchClock::now();
+		SimStartLevel(s);
+		EffectsStartLevel(fx);
+		SnapshotClear(snapshots);
+		SnapshotPush(snapshots, s);
+		double ms = ElapsedMs(start, BenchClock::now());
+
+		startMs += ms;
+		if (ms > startWorst) startWorst = ms;
+		if (n == 0) memoryAtStart = EffectsMemory(fx);
+
+		//First hit of the level, a splinter.
+		start = BenchClock::now();
+		EffectsBlockHit(fx, &s->blocks, s->blocks.live[0], 1);
+		ms = ElapsedMs(start, BenchClock::now());
+
+		hitMs += ms;
+		if (ms > hitWorst) hitWorst = ms;
+	}
+
+	printf("Level start: %d levels.\n", levels);
+	printf("  start avg %.4f ms, worst %.4f ms, budget %.2f ms.\n", startMs / levels, startWorst, TIME_STEP);
+	printf("  first splinter avg %.4f ms, worst %.4f ms (the first one allocates).\n", hitMs / levels, hitWorst);
+	printf("  effects %d KB at level start, %d KB after splinters.\n", memoryAtStart / 1024, EffectsMemory(fx) / 1024);
+
+	EffectsFree(fx);
+	delete snapshots;
+	delete fx;
+	delete s;
+
+	return startWorst <= TIME_STEP;
+}
+
+//******
+//PeakMemoryBytes
+//Largest resident size of the process so far.
+//******
+static long long PeakMemoryBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+	return (long long)counters.PeakWorkingSetSize;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+	return (long long)usage.ru_maxrss;
+#else
+	return (long long)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+//******
+//Percentile
+//times is sorted.
+//******
+static double Percentile(const double *times, int count, double p)
+{
+	if (count == 0) return 0.0;
+
+	int at = (int)(p / 100.0 * count);
+	if (at >= count) at = count - 1;
+	return times[at];
+}
+
+//******
+//PrintTimes
+//Sorts times. Returns the 99th percentile.
+//******
+static double PrintTimes(const char *name, double *times, int count)
+{
+	std::sort(times, times + count);
+
+	const double p99 = Percentile(times, count, 99.0);
+	printf("  %s p50 %.4f ms, p90 %.4f ms, p99 %.4f ms, max %.4f ms.\n", name,
+		Percentile(times, count, 50.0), Percentile(times, count, 90.0), p99, count > 0 ? times[count - 1] : 0.0);
+	return p99;
+}
+
+//******
+//EffectsBenchBegin
+//******
+void EffectsBenchBegin(EffectsBench *bench, SimState *s, Effects *fx, int hitsPerTick, int explosionsPerTick, int ticks)
+{
+	bench->s  = s;
+	bench->fx = fx;
+	RngSeed(&bench->rng, 1, RNG_STREAM_BENCH);
+
+	bench->hitsPerTick       = hitsPerTick;
+	bench->explosionsPerTick = explosionsPerTick;
+	bench->ticks             = ticks;
+	bench->tick              = 0;
+
+	bench->tickMs  = DBG_NEW double[ticks > 0 ? ticks : 1];
+	bench->frameMs = DBG_NEW double[ticks > 0 ? ticks : 1];
+	bench->frames  = 0;
+	bench->totalMs = 0.0;
+
+	bench->peakParticles    = 0;
+	bench->peakStoredTrails = 0;
+	bench->peakExplosions   = 0;
+	bench->peakEffectsBytes = 0;
+}
+
+//******
+//EffectsBenchTick
+//******
+bool EffectsBenchTick(EffectsBench *bench)
+{
+	if (bench->tick == bench->ticks) return false;
+
+	const BlockStore *blocks = &bench->s->blocks;
+	Effects *fx = bench->fx;
+
+	const BenchClock::time_point start = BenchClock::now();
+
+	if (blocks->liveCount > 0)
+	{
+		for (int k = 0; k != bench->hitsPerTick; ++k)
+		{
+			EffectsBlockHit(fx, blocks, blocks->live[RngInt(&bench->rng, blocks->liveCount)], 1);
+		}
+		for (int k = 0; k != bench->explosionsPerTick; ++k)
+		{
+			EffectsBlockHit(fx, blocks, blocks->live[RngInt(&bench->rng, blocks->liveCount)], 0);
+		}
+	}
+	EffectsUpdate(fx, TIME_STEP);
+
+	const double ms = ElapsedMs(start, BenchClock::now());
+	bench->tickMs[bench->tick++] = ms;
+	bench->totalMs += ms;
+
+	//Headless, ended trails are kept until the pool is full, so only the live ones compare with eager particles.
+	const int particles = fx->splitterTrails ? ParticleTrailsLive(fx->splitterTrails) : fx->splitters ? fx->splitters->count : 0;
+	if (particles > bench->peakParticles) bench->peakParticles = particles;
+	if (fx->splitterTrails && fx->splitterTrails->count > bench->peakStoredTrails) bench->peakStoredTrails = fx->splitterTrails->count;
+	if (fx->explosions.count > bench->peakExplosions) bench->peakExplosions = fx->explosions.count;
+	if (EffectsMemory(fx) > bench->peakEffectsBytes) bench->peakEffectsBytes = EffectsMemory(fx);
+
+	return true;
+}
+
+//******
+//EffectsBenchFrame
+//******
+void EffectsBenchFrame(EffectsBench *bench, double ms)
+{
+	if (bench->frames < bench->ticks) bench->frameMs[bench->frames++] = ms;
+}
+
+//******
+//EffectsBenchEnd
+//******
+bool EffectsBenchEnd(EffectsBench *bench)
+{
+	const int ticks = bench->tick;
+
+	printf("Effects: %d splinters and %d explosions per tick, %d ticks%s.\n", bench->hitsPerTick, bench->explosionsPerTick, ticks, bench->frames > 0 ? ", rendered" : "");
+	printf("  %.0f ticks/sec", ticks / (bench->totalMs / 1000.0));
+	if (bench->frames > 0)
+	{
+		double frameTotal = 0.0;
+		for (int i = 0; i != bench->frames; ++i) frameTotal += bench->frameMs[i];
+		printf(", %.0f frames/sec", bench->frames / (frameTotal / 1000.0));
+	}
+	printf(".\n");
+
+	double worst = PrintTimes("tick ", bench->tickMs, ticks);
+	if (bench->frames > 0) worst = PrintTimes("frame", bench->frameMs, bench->frames);
+
+	printf("  peak %d particles, %d explosions, effects %d KB, process %lld KB.\n",
+		bench->peakParticles, bench->peakExplosions, bench->peakEffectsBytes / 1024, PeakMemoryBytes() / 1024);
+	if (bench->peakStoredTrails > 0) printf("  peak %d stored trails, ended ones included.\n", bench->peakStoredTrails);
+
+	delete[] bench->tickMs;
+	delete[] bench->frameMs;
+	bench->tickMs  = NULL;
+	bench->frameMs = NULL;
+
+	return worst <= TIME_STEP;
+}
+
+//******
+//BenchEffects
+//******
+bool BenchEffects(int hitsPerTick, int explosionsPerTick, int ticks, int threads, bool lazySplitters)
+{
+	SimState *s    = DBG_NEW SimState();
+	Effects  *fx   = DBG_NEW Effects;
+	JobPool  *jobs = DBG_NEW JobPool;
+
+	SimInit(s);
+	SimStartLevel(s);
+	JobsInit(jobs, threads);
+	EffectsInit(fx);
+	EffectsStartLevel(fx);
+	fx->jobs          = jobs;
+	fx->lazySplitters = lazySplitters;
+
+	EffectsBench bench;
+	EffectsBenchBegin(&bench, s, fx, hitsPerTick, explosionsPerTick, ticks);
+	while (EffectsBenchTick(&bench)) {}
+	const bool inBudget = EffectsBenchEnd(&bench);
+
+	EffectsFree(fx);
+	JobsFree(jobs);
+	delete jobs;
+	delete fx;
+	delete s;
+
+	return inBudget;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Random.h"
+
+struct SimState;
+struct Effects;
+
+//******
+//BENCH
+//Stress scenes, no sound. Results are printed to stdout.
+//All are headless except the effects scene, which main.cpp can also run with a window.
+//******
+
+//numBalls balls in flight for ticks TIME_STEPs, lost balls are respawned.
+//Returns false if a tick took longer than TIME_STEP.
+bool BenchMultiBall(int numBalls, int ticks);
+
+//OverlapBoxes against OverlapBoxesScalar, numBoxes block sized boxes tested iterations times.
+//Returns false if the two paths disagree.
+bool BenchOverlap(int numBoxes, int iterations);
+
+//ParticlesUpdateScalar against ParticlesUpdate and ParticlesUpdateJobs on threads (0 is one per core),
+//count particles for ticks TIME_STEPs, particles that leave the window are respawned.
+//Returns false if the paths disagree.
+bool BenchParticles(int count, int ticks, int threads);
+
+//Level start as MENUSTATE_NEW_GAME does it without textures, levels times, and the cost of the
+//first splinter after it. Returns false if a level start took longer than TIME_STEP.
+bool BenchStartLevel(int levels);
+
+//******
+//EFFECTS SCENE
+//Every tick hitsPerTick blocks splinter and explosionsPerTick blocks explode, blocks are never removed
+//so the scene stays the same for all ticks. Reports ticks/sec, tick and frame time percentiles and peak memory.
+//******
+struct EffectsBench
+{
+	SimState *s;
+	Effects  *fx;
+	Rng       rng;
+
+	int hitsPerTick;
+	int explosionsPerTick;
+	int ticks;
+	int tick;
+
+	double *tickMs;  //Hits and EffectsUpdate.
+	double *frameMs; //Set by the caller with EffectsBenchFrame, the whole frame with rendering.
+	int     frames;
+	double  totalMs;
+
+	int peakParticles;
+	int peakStoredTrails; //Lazy splitters, ended trails included.
+	int peakExplosions;
+	int peakEffectsBytes;
+};
+
+//s must have a level started, fx is EffectsStartLevel:ed.
+void EffectsBenchBegin(EffectsBench *bench, SimState *s, Effects *fx, int hitsPerTick, int explosionsPerTick, int ticks);
+
+//One TIME_STEP of the scene, returns false when all ticks are done.
+bool EffectsBenchTick(EffectsBench *bench);
+
+//Time of a whole frame, tick and rendering.
+void EffectsBenchFrame(EffectsBench *bench, double ms);
+
+//Print the report and free the bench. Returns false if a tick (or frame) at the 99th percentile took longer than TIME_STEP.
+bool EffectsBenchEnd(EffectsBench *bench);
+
+//The effects scene without rendering, splitters updated on threads (0 is one per core) or as closed form trails.
+bool BenchEffects(int hitsPerTick, int explosionsPerTick, int ticks, int threads, bool lazySplitters);
@@ -0,0 +1,167 @@
+#include "BlockLayer.h"
+
+#include <string.h>
+
+//******
+//CreateTexture
+//******
+static bool CreateTexture(BlockLayer *layer, SDL_Renderer *renderer)
+{
+	layer->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, BLOCK_LAYER_WIDTH, BLOCK_LAYER_HEIGHT);
+	if (!layer->texture) return false;
+
+	SDL_SetTextureBlendMode(layer->texture, SDL_BLENDMODE_BLEND);
+	BlockLayerInvalidate(layer);
+	return true;
+}
+
+//******
+//BlockLayerInit
+//******
+bool BlockLayerInit(BlockLayer *layer, SDL_Renderer *renderer, SDL_Texture *sheet)
+{
+	layer->texture   = NULL;
+	layer->sheet     = sheet;
+	layer->drawCalls = 0;
+
+	if (!SDL_RenderTargetSupported(renderer)) return false;
+	return CreateTexture(layer, renderer);
+}
+
+//******
+//BlockLayerFree
+//******
+void BlockLayerFree(BlockLayer *layer)
+{
+	if (layer->texture) SDL_DestroyTexture(layer->texture);
+	layer->texture = NULL;
+}
+
+//******
+//BlockLayerInvalidate
+//******
+void BlockLayerInvalidate(BlockLayer *layer)
+{
+	layer->numDirty  = 0;
+	layer->redrawAll = true;
+}
+
+//******
+//BlockLayerMarkDirty
+//******
+void BlockLayerMarkDirty(BlockLayer *layer, const BlockStore *blocks, int block)
+{
+	if (layer->redrawAll) return;
+
+	const int column = RealFloor(blocks->posX[block] / BLOCK_WIDTH);
+	const int row    = RealFloor(blocks->posY[block] / BLOCK_HEIGHT);
+	if (column < 0 || column >= BLOCK_LAYER_COLUMNS || row < 0 || row >= BLOCK_LAYER_ROWS) return;
+
+	if (layer->numDirty == MAX_DIRTY_CELLS)
+	{
+		BlockLayerInvalidate(layer);
+		return;
+	}
+
+	layer->dirtyRow[layer->numDirty]    = (short)row;
+	layer->dirtyColumn[layer->numDirty] = (short)column;
+	++layer->numDirty;
+}
+
+//******
+//BlockLayerEvent
+//******
+void BlockLayerEvent(BlockLayer *layer, const SDL_Event *event)
+{
+	if (event->type == SDL_RENDER_TARGETS_RESET) BlockLayerInvalidate(layer);
+}
+
+//******
+//CellFrame
+//What cell [row][column] should hold, see BlockLayer::drawn.
+//******
+static inline int CellFrame(const BlockStore *blocks, int row, int column)
+{
+	const int i = blocks->grid.cell[row][column];
+	if (i == GRID_EMPTY) return 0;
+
+	return 1 + blocks->type[i] * 2 + (blocks->health[i] == 1 ? 1 : 0);
+}
+
+//******
+//DrawCell
+//Blend mode is none, so the sprite replaces the cell including alpha.
+//******
+static void DrawCell(BlockLayer *layer, SDL_Renderer *renderer, int row, int column, int frame)
+{
+	const SDL_Rect dest = { column * BLOCK_WIDTH, row * BLOCK_HEIGHT, BLOCK_WIDTH, BLOCK_HEIGHT };
+
+	++layer->drawCalls;
+	if (frame == 0)
+	{
+		SDL_RenderFillRect(renderer, &dest);
+	}
+	else
+	{
+		const int type = (frame - 1) / 2;
+		const int hurt = (frame - 1) % 2;
+		const SDL_Rect src = { type * BLOCK_WIDTH, hurt * BLOCK_HEIGHT, BLOCK_WIDTH, BLOCK_HEIGHT };
+		SDL_RenderCopy(renderer, layer->sheet, &src, &dest);
+	}
+
+	layer->drawn[row][column] = (unsigned char)frame;
+}
+
+//******
+//BlockLayerUpdate
+//******
+void BlockLayerUpdate(BlockLayer *layer, SDL_Renderer *renderer, const BlockStore *blocks)
+{
+	layer->drawCalls = 0;
+	if (!layer->texture || (!layer->redrawAll && layer->numDirty == 0)) return;
+
+	SDL_BlendMode sheetBlend, drawBlend;
+	SDL_GetTextureBlendMode(layer->sheet, &sheetBlend);
+	SDL_GetRenderDrawBlendMode(renderer, &drawBlend);
+	SDL_SetTextureBlendMode(layer->sheet, SDL_BLENDMODE_NONE);
+
+	SDL_SetRenderTarget(renderer, layer->texture);
+	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+	SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+
+	if (layer->redrawAll)
+	{
+		++layer->drawCalls;
+		SDL_RenderClear(renderer);
+		memset(layer->drawn, 0, sizeof(layer->drawn));
+
+		for (int n = 0; n != blocks->liveCount; ++n)
+		{
+			const int i = blocks->live[n];
+			const int column = RealFloor(blocks->posX[i] / BLOCK_WIDTH);
+			const int row    = RealFloor(blocks->posY[i] / BLOCK_HEIGHT);
+			if (column >= BLOCK_LAYER_COLUMNS || row >= BLOCK_LAYER_ROWS) continue;
+
+			DrawCell(layer, renderer, row, column, CellFrame(blocks, row, column));
+		}
+	}
+	else
+	{
+		//A cell hit twice in one frame is only drawn once, drawn is updated by the first.
+		for (int n = 0; n != layer->numDirty; ++n)
+		{
+			const int row    = layer->dirtyRow[n];
+			const int column = layer->dirtyColumn[n];
+
+			const int frame = CellFrame(blocks, row, column);
+			if (frame != layer->drawn[row][column]) DrawCell(layer, renderer, row, column, frame);
+		}
+	}
+
+	SDL_SetRenderTarget(renderer, NULL);
+	SDL_SetRenderDrawBlendMode(renderer, drawBlend);
+	SDL_SetTextureBlendMode(layer->sheet, sheetBlend);
+
+	layer->numDirty  = 0;
+	layer->redrawAll = false;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <SDL.h>
+
+#include "Simulation.h"
+
+//******
+//BLOCK LAYER
+//The block field drawn once into a render target texture in field space, then copied to the window
+//at offsetY every frame. Lowering the field only moves the copy. Cells are redrawn when marked dirty,
+//everything is redrawn after BlockLayerInvalidate.
+//The target content is gone after SDL_RENDER_TARGETS_RESET, pass that event to BlockLayerEvent.
+//A device reset loses spriteSheet as well and is not handled here.
+//******
+
+struct BlockLayer
+{
+#define BLOCK_LAYER_WIDTH  WINDOW_WIDTH
+#define BLOCK_LAYER_HEIGHT WINDOW_HEIGHT //Field rows below this can never be seen.
+
+#define BLOCK_LAYER_COLUMNS ((BLOCK_LAYER_WIDTH + BLOCK_WIDTH - 1) / BLOCK_WIDTH)
+#define BLOCK_LAYER_ROWS    ((BLOCK_LAYER_HEIGHT + BLOCK_HEIGHT - 1) / BLOCK_HEIGHT)
+
+#define MAX_DIRTY_CELLS 256 //More than this in one frame and the whole layer is redrawn.
+
+	SDL_Texture *texture;
+	SDL_Texture *sheet; //Block sprites, spriteSheet in main.cpp.
+
+	//What each cell holds in the texture, 0 empty, otherwise 1 + sprite frame.
+	unsigned char drawn[BLOCK_LAYER_ROWS][BLOCK_LAYER_COLUMNS];
+
+	short dirtyRow[MAX_DIRTY_CELLS];
+	short dirtyColumn[MAX_DIRTY_CELLS];
+	int   numDirty;
+	bool  redrawAll;
+
+	int drawCalls; //Render calls made by the last BlockLayerUpdate.
+};
+
+//False if the renderer has no render targets, draw blocks as sprites then.
+bool BlockLayerInit(BlockLayer *layer, SDL_Renderer *renderer, SDL_Texture *sheet);
+void BlockLayerFree(BlockLayer *layer);
+
+//Redraw everything on the next update, a new level or a rewind.
+void BlockLayerInvalidate(BlockLayer *layer);
+
+//Block changed, redraw its cell on the next update.
+void BlockLayerMarkDirty(BlockLayer *layer, const BlockStore *blocks, int block);
+
+//Handles render target resets, other events are ignored.
+void BlockLayerEvent(BlockLayer *layer, const SDL_Event *event);
+
+//Bring the texture up to date with blocks. Call before anything is drawn this frame,
+//it switches the render target.
+void BlockLayerUpdate(BlockLayer *layer, SDL_Renderer *renderer, const BlockStore *blocks);
@@ -0,0 +1,152 @@
+#include "Blocks.h"
+
+#include <cassert>
+#include <string.h>
+
+//******
+//GridCell
+//Cell coordinate for a field space position, not clamped.
+//******
+static inline int GridColumn(Real x)
+{
+	return RealFloor(x / BLOCK_WIDTH);
+}
+
+static inline int GridRow(Real y)
+{
+	return RealFloor(y / BLOCK_HEIGHT);
+}
+
+//******
+//BlockStoreClear
+//******
+void BlockStoreClear(BlockStore *store)
+{
+	store->count     = 0;
+	store->liveCount = 0;
+
+	store->offsetY = 0;
+
+	memset(store->grid.cell, 0xff, sizeof(store->grid.cell)); //GRID_EMPTY
+	memset(store->grid.rowLive, 0, sizeof(store->grid.rowLive));
+	store->grid.lowestRow = -1;
+}
+
+//******
+//BlockStoreAdd
+//******
+int BlockStoreAdd(BlockStore *store, Real x, Real y, int type, int health)
+{
+	assert(store->count < MAX_BLOCKS);
+
+	const int i = store->count++;
+	store->posX[i]   = x;
+	store->posY[i]   = y;
+	store->type[i]   = (unsigned char)type;
+	store->health[i] = (unsigned char)health;
+
+	if (health != 0)
+	{
+		store->live[store->liveCount++] = i;
+
+		const int column = GridColumn(x);
+		const int row    = GridRow(y);
+		assert(column >= 0 && column < GRID_MAX_COLUMNS && row >= 0 && row < GRID_MAX_ROWS);
+		assert(store->grid.cell[row][column] == GRID_EMPTY);
+		store->grid.cell[row][column] = (short)i;
+
+		++store->grid.rowLive[row];
+		if (row > store->grid.lowestRow) store->grid.lowestRow = row;
+	}
+
+	return i;
+}
+
+//******
+//BlockStoreKill
+//Keeps the live list sorted so blocks are tested in the same order as they were created.
+//******
+void BlockStoreKill(BlockStore *store, int index)
+{
+	store->health[index] = 0;
+
+	BlockGrid *grid = &store->grid;
+
+	const int column = GridColumn(store->posX[index]);
+	const int row    = GridRow(store->posY[index]);
+	grid->cell[row][column] = GRID_EMPTY;
+
+	//Bottom row cleared, move up to the next one with blocks left.
+	if (--grid->rowLive[row] == 0 && row == grid->lowestRow)
+	{
+		while (grid->lowestRow >= 0 && grid->rowLive[grid->lowestRow] == 0) --grid->lowestRow;
+	}
+
+	for (int n = 0; n != store->liveCount; ++n)
+	{
+		if (store->live[n] == index)
+		{
+			memmove(&store->live[n], &store->live[n + 1], (store->liveCount - n - 1) * sizeof(int));
+			--store->liveCount;
+			return;
+		}
+	}
+}
+
+//******
+//BlockStoreLower
+//******
+void BlockStoreLower(BlockStore *store, Real dy)
+{
+	store->offsetY += dy;
+}
+
+//******
+//BlockStoreLowestRow
+//******
+bool BlockStoreLowestRow(const BlockStore *store, Real *y)
+{
+	if (store->grid.lowestRow < 0) return false;
+
+	*y = Real(store->grid.lowestRow * BLOCK_HEIGHT) + store->offsetY;
+	return true;
+}
+
+//******
+//BlockStoreQuery
+//******
+int BlockStoreQuery(const BlockStore *store, Real minX, Real minY, Real maxX, Real maxY, int *out, int maxOut)
+{
+	const BlockGrid *grid = &store->grid;
+
+	int column0 = GridColumn(minX);
+	int column1 = GridColumn(maxX);
+	int row0    = GridRow(minY - store->offsetY);
+	int row1    = GridRow(maxY - store->offsetY);
+
+	if (column0 < 0) column0 = 0;
+	if (row0 < 0)    row0 = 0;
+	if (column1 >= GRID_MAX_COLUMNS) column1 = GRID_MAX_COLUMNS - 1;
+	if (row1 >= GRID_MAX_ROWS)       row1 = GRID_MAX_ROWS - 1;
+
+	int count = 0;
+	for (int row = row0; row <= row1; ++row)
+	{
+		for (int column = column0; column <= column1; ++column)
+		{
+			const int i = grid->cell[row][column];
+			if (i == GRID_EMPTY || count == maxOut) continue;
+
+			//Insertion sort, there are only a handful of candidates.
+			int k = count++;
+			while (k > 0 && out[k - 1] > i)
+			{
+				out[k] = out[k - 1];
+				--k;
+			}
+			out[k] = i;
+		}
+	}
+
+	return count;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Real.h"
+
+//******
+//BLOCKS
+//Structure of arrays, only what the collision and draw loops need.
+//Splitters and explosions are kept in Effects.h.
+//******
+
+#define BLOCK_WIDTH  32
+#define BLOCK_HEIGHT 16
+
+#define BLOCK_TYPES 4
+
+//Uniform grid over the block field, one cell per block slot, cell [0][0] at the field origin.
+//Blocks are laid out on BLOCK_WIDTH x BLOCK_HEIGHT steps so a cell never holds more than one block.
+struct BlockGrid
+{
+#define GRID_MAX_COLUMNS 64
+#define GRID_MAX_ROWS    256
+#define GRID_EMPTY       -1
+
+	short cell[GRID_MAX_ROWS][GRID_MAX_COLUMNS]; //Live block index or GRID_EMPTY.
+
+	//Live blocks per row, and the lowest row that has any (-1 when the field is cleared).
+	int rowLive[GRID_MAX_ROWS];
+	int lowestRow;
+};
+
+//Block positions are relative to the field. The whole field scrolls down by offsetY,
+//so lowering it touches one float and the grid never has to be rebuilt.
+struct BlockStore
+{
+#define MAX_BLOCKS 4096
+
+	Real          posX[MAX_BLOCKS];
+	Real          posY[MAX_BLOCKS]; //Field space, use BlockY for the window position.
+	unsigned char health[MAX_BLOCKS];
+	unsigned char type[MAX_BLOCKS];
+	int           count;
+
+	//Indices of blocks with health != 0, in ascending order.
+	int live[MAX_BLOCKS];
+	int liveCount;
+
+	BlockGrid grid;
+
+	Real offsetY;
+};
+
+//Window y of block i.
+inline Real BlockY(const BlockStore *store, int i)
+{
+	return store->posY[i] + store->offsetY;
+}
+
+void BlockStoreClear(BlockStore *store);
+
+//Returns index of the new block. x and y are in field space.
+int BlockStoreAdd(BlockStore *store, Real x, Real y, int type, int health);
+
+//Removes block from the live list and the grid, health is set to 0.
+void BlockStoreKill(BlockStore *store, int index);
+
+//Move every block dy pixels down.
+void BlockStoreLower(BlockStore *store, Real dy);
+
+//Window y of the top of the lowest row that still has live blocks, false if there are none.
+bool BlockStoreLowestRow(const BlockStore *store, Real *y);
+
+//Live blocks whose cell touches the box (window coordinates), written to out in ascending index order.
+//Returns number of blocks written.
+int BlockStoreQuery(const BlockStore *store, Real minX, Real minY, Real maxX, Real maxY, int *out, int maxOut);
@@ -0,0 +1,288 @@
+#include "Collision.h"
+
+#include <float.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define OVERLAP_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OVERLAP_SSE2
+#endif
+
+#if defined(OVERLAP_AVX2) || defined(OVERLAP_SSE2)
+//Set bits in a 4 bit movemask.
+static const int bitCount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+#endif
+
+//******
+//SweptAxis
+//Time interval on one axis where the boxes overlap.
+//******
+static void SweptAxis(Real aMin, Real aMax, Real v, Real bMin, Real bMax, Real *entry, Real *exit)
+{
+	if (v > 0)
+	{
+		*entry = (bMin - aMax) / v;
+		*exit  = (bMax - aMin) / v;
+	}
+	else if (v < 0)
+	{
+		*entry = (bMax - aMin) / v;
+		*exit  = (bMin - aMax) / v;
+	}
+	else if (aMin < bMax && aMax > bMin)
+	{
+		*entry = -REAL_MAX;
+		*exit  =  REAL_MAX;
+	}
+	else
+	{
+		*entry = REAL_MAX;
+		*exit  = -REAL_MAX;
+	}
+}
+
+//******
+//SweptCollision
+//******
+SweepResult SweptCollision(const SweptBox &boxA, const RealVec2 &vel, const SweptBox &boxB)
+{
+	SweepResult result;
+	result.hit  = false;
+	result.time = 1;
+
+	Real entryX, exitX, entryY, exitY;
+	SweptAxis(boxA.pos.x, boxA.pos.x + boxA.size.x, vel.x, boxB.pos.x, boxB.pos.x + boxB.size.x, &entryX, &exitX);
+	SweptAxis(boxA.pos.y, boxA.pos.y + boxA.size.y, vel.y, boxB.pos.y, boxB.pos.y + boxB.size.y, &entryY, &exitY);
+
+	const Real entry = entryX > entryY ? entryX : entryY;
+	const Real exit  = exitX  < exitY  ? exitX  : exitY;
+
+	//No overlap during this move, or only touching.
+	if (entry >= exit || entry > 1 || exit <= 0)
+	{
+		return result;
+	}
+
+	//The axis that started to overlap last is the face that was hit.
+	if (entryX > entryY)
+	{
+		result.normal = RealVec2(vel.x > 0 ? -1 : 1, 0);
+	}
+	else
+	{
+		result.normal = RealVec2(0, vel.y > 0 ? -1 : 1);
+	}
+
+	//Moving away from that face, let it go.
+	if (vel.DotProduct(result.normal) >= 0)
+	{
+		return result;
+	}
+
+	result.hit  = true;
+	result.time = entry > 0 ? entry : 0;
+	return result;
+}
+
+//******
+//OverlapBox
+//One lane of OverlapBoxes.
+//******
+static inline int OverlapBox(float aMinX, float aMinY, float aMaxX, float aMaxY, float bMinX, float bMinY, const Vec2 &size,
+                             float *normalX, float *normalY, float *depth)
+{
+	//Distance boxA has to move left/right/up/down to get out.
+	const float left  = aMaxX - bMinX;
+	const float right = bMinX + size.x - aMinX;
+	const float up    = aMaxY - bMinY;
+	const float down  = bMinY + size.y - aMinY;
+
+	if (left <= 0.0f || right <= 0.0f || up <= 0.0f || down <= 0.0f)
+	{
+		*normalX = 0.0f;
+		*normalY = 0.0f;
+		*depth   = 0.0f;
+		return 0;
+	}
+
+	const float penX = right < left ? right : left;
+	const float penY = down < up ? down : up;
+
+	//Shortest way out.
+	if (penX < penY)
+	{
+		*normalX = right < left ? 1.0f : -1.0f;
+		*normalY = 0.0f;
+		*depth   = penX;
+	}
+	else
+	{
+		*normalX = 0.0f;
+		*normalY = down < up ? 1.0f : -1.0f;
+		*depth   = penY;
+	}
+	return 1;
+}
+
+//******
+//OverlapBoxesScalar
+//******
+int OverlapBoxesScalar(const AxisBox &boxA, const float *posX, const float *posY, const Vec2 &size, int count,
+                       float *normalX, float *normalY, float *depth)
+{
+	const float aMinX = boxA.pos.x;
+	const float aMinY = boxA.pos.y;
+	const float aMaxX = boxA.pos.x + boxA.size.x;
+	const float aMaxY = boxA.pos.y + boxA.size.y;
+
+	int hits = 0;
+	for (int i = 0; i != count; ++i)
+	{
+		hits += OverlapBox(aMinX, aMinY, aMaxX, aMaxY, posX[i], posY[i], size, &normalX[i], &normalY[i], &depth[i]);
+	}
+	return hits;
+}
+
+#if defined(OVERLAP_AVX2)
+
+//******
+//OverlapBoxes
+//AVX2, 8 boxes per iteration.
+//******
+int OverlapBoxes(const AxisBox &boxA, const float *posX, const float *posY, const Vec2 &size, int count,
+                 float *normalX, float *normalY, float *depth)
+{
+	const float aMinX = boxA.pos.x;
+	const float aMinY = boxA.pos.y;
+	const float aMaxX = boxA.pos.x + boxA.size.x;
+	const float aMaxY = boxA.pos.y + boxA.size.y;
+
+	const __m256 vaMinX = _mm256_set1_ps(aMinX);
+	const __m256 vaMinY = _mm256_set1_ps(aMinY);
+	const __m256 vaMaxX = _mm256_set1_ps(aMaxX);
+	const __m256 vaMaxY = _mm256_set1_ps(aMaxY);
+	const __m256 sizeX  = _mm256_set1_ps(size.x);
+	const __m256 sizeY  = _mm256_set1_ps(size.y);
+	const __m256 zero   = _mm256_setzero_ps();
+	const __m256 one    = _mm256_set1_ps(1.0f);
+	const __m256 minus  = _mm256_set1_ps(-1.0f);
+
+	int hits = 0;
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 bMinX = _mm256_loadu_ps(posX + i);
+		const __m256 bMinY = _mm256_loadu_ps(posY + i);
+
+		const __m256 left  = _mm256_sub_ps(vaMaxX, bMinX);
+		const __m256 right = _mm256_sub_ps(_mm256_add_ps(bMinX, sizeX), vaMinX);
+		const __m256 up    = _mm256_sub_ps(vaMaxY, bMinY);
+		const __m256 down  = _mm256_sub_ps(_mm256_add_ps(bMinY, sizeY), vaMinY);
+
+		const __m256 overlap = _mm256_and_ps(
+			_mm256_and_ps(_mm256_cmp_ps(left, zero, _CMP_GT_OQ), _mm256_cmp_ps(right, zero, _CMP_GT_OQ)),
+			_mm256_and_ps(_mm256_cmp_ps(up, zero, _CMP_GT_OQ), _mm256_cmp_ps(down, zero, _CMP_GT_OQ)));
+
+		const __m256 rightFirst = _mm256_cmp_ps(right, left, _CMP_LT_OQ);
+		const __m256 downFirst  = _mm256_cmp_ps(down, up, _CMP_LT_OQ);
+		const __m256 penX = _mm256_blendv_ps(left, right, rightFirst);
+		const __m256 penY = _mm256_blendv_ps(up, down, downFirst);
+		const __m256 useX = _mm256_cmp_ps(penX, penY, _CMP_LT_OQ);
+
+		const __m256 dirX = _mm256_blendv_ps(minus, one, rightFirst);
+		const __m256 dirY = _mm256_blendv_ps(minus, one, downFirst);
+
+		_mm256_storeu_ps(normalX + i, _mm256_and_ps(overlap, _mm256_and_ps(useX, dirX)));
+		_mm256_storeu_ps(normalY + i, _mm256_and_ps(overlap, _mm256_andnot_ps(useX, dirY)));
+		_mm256_storeu_ps(depth + i,   _mm256_and_ps(overlap, _mm256_blendv_ps(penY, penX, useX)));
+
+		const int mask = _mm256_movemask_ps(overlap);
+		hits += bitCount[mask & 15] + bitCount[mask >> 4];
+	}
+
+	return hits + OverlapBoxesScalar(boxA, posX + i, posY + i, size, count - i, normalX + i, normalY + i, depth + i);
+}
+
+#elif defined(OVERLAP_SSE2)
+
+//******
+//Select
+//mask ? a : b, SSE2 has no blendv.
+//******
+static inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+//******
+//OverlapBoxes
+//SSE2, 4 boxes per iteration.
+//******
+int OverlapBoxes(const AxisBox &boxA, const float *posX, const float *posY, const Vec2 &size, int count,
+                 float *normalX, float *normalY, float *depth)
+{
+	const float aMinX = boxA.pos.x;
+	const float aMinY = boxA.pos.y;
+	const float aMaxX = boxA.pos.x + boxA.size.x;
+	const float aMaxY = boxA.pos.y + boxA.size.y;
+
+	const __m128 vaMinX = _mm_set1_ps(aMinX);
+	const __m128 vaMinY = _mm_set1_ps(aMinY);
+	const __m128 vaMaxX = _mm_set1_ps(aMaxX);
+	const __m128 vaMaxY = _mm_set1_ps(aMaxY);
+	const __m128 sizeX  = _mm_set1_ps(size.x);
+	const __m128 sizeY  = _mm_set1_ps(size.y);
+	const __m128 zero   = _mm_setzero_ps();
+	const __m128 one    = _mm_set1_ps(1.0f);
+	const __m128 minus  = _mm_set1_ps(-1.0f);
+
+	int hits = 0;
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 bMinX = _mm_loadu_ps(posX + i);
+		const __m128 bMinY = _mm_loadu_ps(posY + i);
+
+		const __m128 left  = _mm_sub_ps(vaMaxX, bMinX);
+		const __m128 right = _mm_sub_ps(_mm_add_ps(bMinX, sizeX), vaMinX);
+		const __m128 up    = _mm_sub_ps(vaMaxY, bMinY);
+		const __m128 down  = _mm_sub_ps(_mm_add_ps(bMinY, sizeY), vaMinY);
+
+		const __m128 overlap = _mm_and_ps(
+			_mm_and_ps(_mm_cmpgt_ps(left, zero), _mm_cmpgt_ps(right, zero)),
+			_mm_and_ps(_mm_cmpgt_ps(up, zero), _mm_cmpgt_ps(down, zero)));
+
+		const __m128 rightFirst = _mm_cmplt_ps(right, left);
+		const __m128 downFirst  = _mm_cmplt_ps(down, up);
+		const __m128 penX = Select(rightFirst, right, left);
+		const __m128 penY = Select(downFirst, down, up);
+		const __m128 useX = _mm_cmplt_ps(penX, penY);
+
+		const __m128 dirX = Select(rightFirst, one, minus);
+		const __m128 dirY = Select(downFirst, one, minus);
+
+		_mm_storeu_ps(normalX + i, _mm_and_ps(overlap, _mm_and_ps(useX, dirX)));
+		_mm_storeu_ps(normalY + i, _mm_and_ps(overlap, _mm_andnot_ps(useX, dirY)));
+		_mm_storeu_ps(depth + i,   _mm_and_ps(overlap, Select(useX, penX, penY)));
+
+		hits += bitCount[_mm_movemask_ps(overlap)];
+	}
+
+	return hits + OverlapBoxesScalar(boxA, posX + i, posY + i, size, count - i, normalX + i, normalY + i, depth + i);
+}
+
+#else
+
+//******
+//OverlapBoxes
+//No SIMD on this target.
+//******
+int OverlapBoxes(const AxisBox &boxA, const float *posX, const float *posY, const Vec2 &size, int count,
+                 float *normalX, float *normalY, float *depth)
+{
+	return OverlapBoxesScalar(boxA, posX, posY, size, count, normalX, normalY, depth);
+}
+
+#endif
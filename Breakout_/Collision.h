@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Vector.h"
+#include "Real.h"
+
+struct AxisBox
+{
+	Vec2 pos;
+	Vec2 size;
+};
+
+//Same as AxisBox in simulation numbers.
+struct SweptBox
+{
+	RealVec2 pos;
+	RealVec2 size;
+};
+
+struct SweepResult
+{
+	bool     hit;
+	Real     time;   //Fraction of vel travelled before contact, 0 if the boxes already overlap.
+	RealVec2 normal; //Face of boxB that was hit, points towards boxA.
+};
+
+//******
+//SweptCollision
+//boxA moves by vel, boxB stands still.
+//Touching edges does not count, and neither does a boxA that is already moving away from the hit face.
+//******
+SweepResult SweptCollision(const SweptBox &boxA, const RealVec2 &vel, const SweptBox &boxB);
+
+//******
+//OverlapBoxes
+//SAT for axis aligned boxes: boxA against count boxes of the same size, given as posX/posY arrays.
+//Output is structure of arrays, one entry per box. Adding normal * depth to boxA.pos separates it from that box.
+//Boxes that do not overlap, or only touch, get depth 0 and normal (0, 0).
+//Returns number of overlapping boxes.
+//
+//OverlapBoxes runs 8 (AVX2) or 4 (SSE2) boxes per lane set, OverlapBoxesScalar is the reference.
+//Both give the same bits.
+//******
+int OverlapBoxes(const AxisBox &boxA, const float *posX, const float *posY, const Vec2 &size, int count,
+                 float *normalX, float *normalY, float *depth);
+
+int OverlapBoxesScalar(const AxisBox &boxA, const float *posX, const float *posY, const Vec2 &size, int count,
+                       float *normalX, float *normalY, float *depth);
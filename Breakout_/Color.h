@@ -0,0 +1,9 @@
+#pragma once
+
+struct Color
+{
+	float r;
+	float g;
+	float b;
+	float a;
+};
@@ -0,0 +1,159 @@
+#include "Effects.h"
+
+#include "MemAlloc.h"
+
+//******
+//EffectsInit
+//******
+void EffectsInit(Effects *fx)
+{
+	//Explosion, frames are read row by row.
+	AnimationsInit(&fx->explosions, EXPLOSION_TIME_BETWEEN_FRAMES, (EXPLOSION_MAX_FRAME_X + 1) * EXPLOSION_MAX_FRAME_Y, EXPLOSION_MAX_FRAME_X + 1);
+
+	fx->splitters = NULL;
+	fx->jobs      = NULL;
+	EffectsSeed(fx, 1);
+
+	fx->lazySplitters  = false;
+	fx->splitterTrails = NULL;
+
+	fx->splitterFrame = NULL;
+	fx->splitterDelta = TIME_STEP;
+
+	//Block splitter
+	fx->blockSplitterColor[0] = { 135, 255, 255, 255 };
+	fx->blockSplitterColor[1] = { 135, 63, 255, 255 };
+	fx->blockSplitterColor[2] = { 255, 201, 165, 25 };
+	fx->blockSplitterColor[3] = { 255, 30, 81, 255 };
+}
+
+//******
+//EffectsSeed
+//******
+void EffectsSeed(Effects *fx, unsigned int seed)
+{
+	RngSeed(&fx->rng, seed, RNG_STREAM_EFFECTS);
+}
+
+//******
+//EffectsStartLevel
+//******
+void EffectsStartLevel(Effects *fx)
+{
+	AnimationsClear(&fx->explosions);
+	if (fx->splitters) ParticlesClear(fx->splitters);
+	if (fx->splitterTrails) ParticleTrailsClear(fx->splitterTrails);
+}
+
+//******
+//AllocSplitters
+//First splinter of the game.
+//******
+static void AllocSplitters(Effects *fx)
+{
+	if (!fx->splitters)
+	{
+		fx->splitters = DBG_NEW ParticlePool;
+		ParticlesClear(fx->splitters);
+	}
+
+	if (fx->lazySplitters && !fx->splitterTrails)
+	{
+		fx->splitterTrails = DBG_NEW ParticleTrails;
+		ParticleTrailsClear(fx->splitterTrails);
+	}
+}
+
+//******
+//EffectsBlockHit
+//******
+void EffectsBlockHit(Effects *fx, const BlockStore *store, int block, int health)
+{
+	//From where the block is now.
+	const Vec2 pos = Vec2(RealToFloat(store->posX[block]), RealToFloat(BlockY(store, block)));
+
+	if (health == 0)
+	{
+		//Explosion centered on the block.
+		AnimationsStart(&fx->explosions, Vec2(pos.x - (EXPLOSION_WIDTH / 2) + (BLOCK_WIDTH / 2), pos.y - (EXPLOSION_HEIGHT / 2) + (BLOCK_HEIGHT / 2)));
+	}
+	else
+	{
+		//Splitter
+		AllocSplitters(fx);
+
+		float velX[MAX_NUMBER_OF_SPLITTER], velY[MAX_NUMBER_OF_SPLITTER];
+		float accX[MAX_NUMBER_OF_SPLITTER], accY[MAX_NUMBER_OF_SPLITTER];
+		RngFillRange(&fx->rng, velX, MAX_NUMBER_OF_SPLITTER, -0.1f, 0.3f);
+		RngFillRange(&fx->rng, velY, MAX_NUMBER_OF_SPLITTER, -6.0f, -4.0f);
+		RngFillRange(&fx->rng, accX, MAX_NUMBER_OF_SPLITTER, -0.8f, 0.8f);
+		RngFillRange(&fx->rng, accY, MAX_NUMBER_OF_SPLITTER, -0.8f, 0.8f);
+
+		for (int k = 0; k != MAX_NUMBER_OF_SPLITTER; ++k)
+		{
+			const Vec2 vel = Vec2(velX[k], velY[k]);
+			const Vec2 acc = Vec2(accX[k], accY[k]);
+			if (fx->lazySplitters) ParticleTrailsSpawn(fx->splitterTrails, pos, vel, acc, store->type[block]);
+			else ParticlesSpawn(fx->splitters, pos, vel, acc, store->type[block]);
+		}
+	}
+}
+
+//******
+//EffectsUpdate
+//******
+void EffectsUpdate(Effects *fx, float delta)
+{
+	//Splitter
+	if (fx->splitterTrails) ParticleTrailsTick(fx->splitterTrails);
+	else if (fx->splitters) ParticlesUpdateJobs(fx->splitters, delta, fx->jobs);
+	fx->splitterDelta = delta;
+
+	//Explosion
+	AnimationsUpdate(&fx->explosions, delta);
+}
+
+//******
+//EffectsSplitters
+//******
+const ParticlePool *EffectsSplitters(Effects *fx, float alpha)
+{
+	if (fx->splitterTrails)
+	{
+		ParticleTrailsEvaluate(fx->splitterTrails, fx->splitters, alpha);
+		return fx->splitters;
+	}
+
+	if (!fx->splitters || alpha >= 1.0f) return fx->splitters;
+
+	if (!fx->splitterFrame) fx->splitterFrame = DBG_NEW ParticlePool;
+	ParticlesInterpolate(fx->splitters, fx->splitterDelta, alpha, fx->splitterFrame);
+	return fx->splitterFrame;
+}
+
+//******
+//EffectsMemory
+//******
+int EffectsMemory(const Effects *fx)
+{
+	int bytes = sizeof(Effects);
+	if (fx->splitters) bytes += sizeof(ParticlePool);
+	if (fx->splitterTrails) bytes += sizeof(ParticleTrails);
+	if (fx->splitterFrame) bytes += sizeof(ParticlePool);
+	return bytes;
+}
+
+//******
+//EffectsFree
+//******
+void EffectsFree(Effects *fx)
+{
+	delete fx->splitters;
+	fx->splitters = NULL;
+
+	delete fx->splitterTrails;
+	fx->splitterTrails = NULL;
+
+	delete fx->splitterFrame;
+	fx->splitterFrame = NULL;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Vector.h"
+#include "Color.h"
+#include "Simulation.h"
+#include "Particles.h"
+#include "Animation.h"
+#include "Random.h"
+
+//******
+//EFFECTS
+//Splitters and explosions, started by hits reported from SimStep.
+//Only visual, the simulation never reads from here.
+//******
+
+struct Effects
+{
+	//Explosions of destroyed blocks.
+#define EXPLOSION_WIDTH  128.0f
+#define EXPLOSION_HEIGHT 128.0f
+#define EXPLOSION_MAX_FRAME_X 3
+#define EXPLOSION_MAX_FRAME_Y 5
+#define EXPLOSION_TIME_BETWEEN_FRAMES TIME_STEP * 3 //Change frame 20 times per second.
+	AnimationPool explosions;
+
+	//Splitters from every block, allocated by the first hit that splinters a block.
+#define MAX_NUMBER_OF_SPLITTER 12 //Per hit.
+	Rng rng; //RNG_STREAM_EFFECTS, splitter directions.
+	ParticlePool *splitters;
+	Color blockSplitterColor[BLOCK_TYPES];
+	JobPool *jobs; //Splitter update threads, NULL updates on the caller.
+
+	//Splitters as closed form trails, splitters is then only filled in by EffectsSplitters.
+	bool lazySplitters;
+	ParticleTrails *splitterTrails;
+
+	//Stepped splitters drawn between ticks, filled in by EffectsSplitters.
+	ParticlePool *splitterFrame;
+	float         splitterDelta; //Given to the last EffectsUpdate.
+};
+
+void EffectsInit(Effects *fx);
+
+void EffectsSeed(Effects *fx, unsigned int seed);
+
+//Drop every running effect.
+void EffectsStartLevel(Effects *fx);
+
+//health is what the block has left after the hit.
+void EffectsBlockHit(Effects *fx, const BlockStore *store, int block, int health);
+
+void EffectsUpdate(Effects *fx, float delta);
+
+//Splitters to draw alpha of the way from the tick before (0) to the last EffectsUpdate (1).
+//NULL if no block has splintered yet.
+const ParticlePool *EffectsSplitters(Effects *fx, float alpha);
+
+//Bytes allocated for effect state.
+int EffectsMemory(const Effects *fx);
+
+void EffectsFree(Effects *fx);
@@ -0,0 +1,110 @@
+#include "Frame.h"
+#include "MemAlloc.h"
+
+#include <string.h>
+
+//******
+//FrameInit
+//******
+void FrameInit(FrameState *frame)
+{
+	frame->splitterCopy = NULL;
+
+	FrameBegin(frame);
+	FrameResetBlocks(frame);
+}
+
+//******
+//FrameFree
+//******
+void FrameFree(FrameState *frame)
+{
+	delete frame->splitterCopy;
+	frame->splitterCopy = NULL;
+}
+
+//******
+//FrameBegin
+//******
+void FrameBegin(FrameState *frame)
+{
+	frame->numSprites = 0;
+	frame->splitters  = NULL;
+}
+
+//******
+//FrameAddSprite
+//******
+bool FrameAddSprite(FrameState *frame, int layer, int texture, const Vec2 &pos, const Vec2 &size, const Vec2 &src)
+{
+	if (frame->numSprites == MAX_FRAME_SPRITES) return false;
+
+	FrameSprite *sprite = &frame->sprites[frame->numSprites++];
+	sprite->layer   = layer;
+	sprite->texture = texture;
+	sprite->pos     = pos;
+	sprite->size    = size;
+	sprite->frame   = src;
+	return true;
+}
+
+//******
+//FrameMarkBlock
+//******
+void FrameMarkBlock(FrameState *frame, int block)
+{
+	if (frame->blocksReset) return;
+
+	if (frame->numDirtyBlocks == MAX_FRAME_DIRTY_BLOCKS)
+	{
+		FrameResetBlocks(frame);
+		return;
+	}
+	frame->dirtyBlocks[frame->numDirtyBlocks++] = block;
+}
+
+//******
+//FrameResetBlocks
+//******
+void FrameResetBlocks(FrameState *frame)
+{
+	frame->numDirtyBlocks = 0;
+	frame->blocksReset    = true;
+}
+
+//******
+//FrameClearBlocks
+//******
+void FrameClearBlocks(FrameState *frame)
+{
+	frame->numDirtyBlocks = 0;
+	frame->blocksReset    = false;
+}
+
+//******
+//FrameCopySplitters
+//******
+void FrameCopySplitters(FrameState *frame)
+{
+	if (!frame->splitters || frame->splitters == frame->splitterCopy) return;
+
+	if (!frame->splitterCopy) frame->splitterCopy = DBG_NEW ParticlePool;
+
+	const ParticlePool *from = frame->splitters;
+	ParticlePool *to = frame->splitterCopy;
+
+	memcpy(to->posX, from->posX, from->count * sizeof(float));
+	memcpy(to->posY, from->posY, from->count * sizeof(float));
+	memcpy(to->color, from->color, from->count);
+	to->count = from->count;
+
+	frame->splitters = to;
+}
+
+//******
+//FrameCopyBlocks
+//******
+void FrameCopyBlocks(FrameState *frame, const BlockStore *blocks)
+{
+	memcpy(&frame->blocks, blocks, sizeof(BlockStore));
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Vector.h"
+#include "Blocks.h"
+#include "Particles.h"
+
+//******
+//FRAME STATE
+//What one play frame draws, built from the simulation and read by the renderer. No SDL in here,
+//textures are ids the renderer looks up. With -pipeline a frame is built on the simulation thread
+//while the one before it is drawn, so it keeps its own copy of everything the renderer reads.
+//******
+
+struct FrameSprite
+{
+	int  layer;   //SpriteLayer.
+	int  texture; //Id given by the renderer.
+	Vec2 pos;
+	Vec2 size;
+	Vec2 frame;
+};
+
+struct FrameState
+{
+#define MAX_FRAME_SPRITES 16384
+#define MAX_FRAME_DIRTY_BLOCKS 256 //More hits than this and every block is redrawn.
+
+	FrameSprite sprites[MAX_FRAME_SPRITES];
+	int numSprites;
+
+	//Splitters to draw, NULL if there are none. Points into Effects, or at splitterCopy after FrameCopySplitters.
+	const ParticlePool *splitters;
+	ParticlePool *splitterCopy;
+
+	//Blocks hit since the renderer last read them, blocksReset when every block may have changed.
+	int  dirtyBlocks[MAX_FRAME_DIRTY_BLOCKS];
+	int  numDirtyBlocks;
+	bool blocksReset;
+
+	//Filled by FrameCopyBlocks.
+	BlockStore blocks;
+};
+
+void FrameInit(FrameState *frame);
+void FrameFree(FrameState *frame);
+
+//Drop sprites and splitters, dirty blocks are kept until FrameClearBlocks.
+void FrameBegin(FrameState *frame);
+
+//Returns false if full.
+bool FrameAddSprite(FrameState *frame, int layer, int texture, const Vec2 &pos, const Vec2 &size, const Vec2 &src);
+
+void FrameMarkBlock(FrameState *frame, int block);
+void FrameResetBlocks(FrameState *frame);
+void FrameClearBlocks(FrameState *frame);
+
+//Copies for a frame that is drawn while the simulation goes on.
+void FrameCopySplitters(FrameState *frame);
+void FrameCopyBlocks(FrameState *frame, const BlockStore *blocks);
@@ -0,0 +1,207 @@
+#include "Jobs.h"
+#include "MemAlloc.h"
+
+#include <cassert>
+
+//******
+//RunJobs
+//Take jobs until there are none left.
+//******
+static void RunJobs(JobPool *pool)
+{
+	for (;;)
+	{
+		const int job = pool->next.fetch_add(1);
+		if (job >= pool->count) return;
+
+		pool->func(pool->data, job);
+	}
+}
+
+//******
+//WorkerMain
+//******
+static void WorkerMain(JobPool *pool)
+{
+	unsigned int seen = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> guard(pool->lock);
+			while (!pool->quit && pool->batch == seen) pool->wake.wait(guard);
+
+			if (pool->quit) return;
+			seen = pool->batch;
+		}
+
+		RunJobs(pool);
+
+		std::lock_guard<std::mutex> guard(pool->lock);
+		if (--pool->busy == 0) pool->done.notify_one();
+	}
+}
+
+//******
+//JobsInit
+//******
+void JobsInit(JobPool *pool, int threads)
+{
+	if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+	if (threads <= 0) threads = 1;
+	if (threads > MAX_WORKERS + 1) threads = MAX_WORKERS + 1;
+
+	pool->func  = NULL;
+	pool->data  = NULL;
+	pool->count = 0;
+	pool->next  = 0;
+	pool->batch = 0;
+	pool->busy  = 0;
+	pool->quit  = false;
+
+	pool->numWorkers = threads - 1;
+	for (int i = 0; i != pool->numWorkers; ++i)
+	{
+		pool->workers[i] = DBG_NEW std::thread(WorkerMain, pool);
+	}
+}
+
+//******
+//JobsFree
+//******
+void JobsFree(JobPool *pool)
+{
+	{
+		std::lock_guard<std::mutex> guard(pool->lock);
+		pool->quit = true;
+	}
+	pool->wake.notify_all();
+
+	for (int i = 0; i != pool->numWorkers; ++i)
+	{
+		pool->workers[i]->join();
+		delete pool->workers[i];
+		pool->workers[i] = NULL;
+	}
+	pool->numWorkers = 0;
+}
+
+//******
+//JobsThreads
+//******
+int JobsThreads(const JobPool *pool)
+{
+	return pool->numWorkers + 1;
+}
+
+//******
+//JobsRun
+//******
+void JobsRun(JobPool *pool, int count, JobFunc func, void *data)
+{
+	if (count <= 0) return;
+
+	//Not worth waking anyone.
+	if (pool->numWorkers == 0 || count == 1)
+	{
+		for (int job = 0; job != count; ++job) func(data, job);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(pool->lock);
+		assert(pool->busy == 0);
+
+		pool->func  = func;
+		pool->data  = data;
+		pool->count = count;
+		pool->next  = 0;
+		pool->busy  = pool->numWorkers;
+		++pool->batch;
+	}
+	pool->wake.notify_all();
+
+	RunJobs(pool);
+
+	//Workers still read the batch, wait until they let go of it.
+	std::unique_lock<std::mutex> guard(pool->lock);
+	while (pool->busy != 0) pool->done.wait(guard);
+}
+
+//******
+//JobThreadMain
+//******
+static void JobThreadMain(JobThread *worker)
+{
+	std::unique_lock<std::mutex> guard(worker->lock);
+	for (;;)
+	{
+		while (!worker->quit && !worker->func) worker->wake.wait(guard);
+		if (worker->quit) return;
+
+		JobFunc func = worker->func;
+		void   *data = worker->data;
+
+		guard.unlock();
+		func(data, 0);
+		guard.lock();
+
+		worker->func = NULL;
+		worker->busy = false;
+		worker->done.notify_one();
+	}
+}
+
+//******
+//JobThreadInit
+//******
+void JobThreadInit(JobThread *worker)
+{
+	worker->func = NULL;
+	worker->data = NULL;
+	worker->busy = false;
+	worker->quit = false;
+
+	worker->thread = DBG_NEW std::thread(JobThreadMain, worker);
+}
+
+//******
+//JobThreadFree
+//******
+void JobThreadFree(JobThread *worker)
+{
+	JobThreadWait(worker);
+	{
+		std::lock_guard<std::mutex> guard(worker->lock);
+		worker->quit = true;
+	}
+	worker->wake.notify_one();
+
+	worker->thread->join();
+	delete worker->thread;
+	worker->thread = NULL;
+}
+
+//******
+//JobThreadStart
+//******
+void JobThreadStart(JobThread *worker, JobFunc func, void *data)
+{
+	{
+		std::lock_guard<std::mutex> guard(worker->lock);
+		assert(!worker->busy);
+
+		worker->func = func;
+		worker->data = data;
+		worker->busy = true;
+	}
+	worker->wake.notify_one();
+}
+
+//******
+//JobThreadWait
+//******
+void JobThreadWait(JobThread *worker)
+{
+	std::unique_lock<std::mutex> guard(worker->lock);
+	while (worker->busy) worker->done.wait(guard);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+//******
+//JOBS
+//Fixed pool of worker threads for parallel loops. JobsRun hands out job indices
+//and the calling thread takes part, it returns when every job is done.
+//******
+
+typedef void (*JobFunc)(void *data, int job);
+
+struct JobPool
+{
+#define MAX_WORKERS 63
+
+	std::thread *workers[MAX_WORKERS];
+	int numWorkers; //Threads besides the caller.
+
+	std::mutex              lock;
+	std::condition_variable wake;
+	std::condition_variable done;
+
+	//Current batch.
+	JobFunc          func;
+	void            *data;
+	int              count;
+	std::atomic<int> next;
+	unsigned int     batch; //Bumped for every JobsRun, workers wait for it to change.
+	int              busy;  //Workers not yet done with the batch.
+	bool             quit;
+};
+
+//threads is the total including the caller, 0 is one per core.
+void JobsInit(JobPool *pool, int threads);
+
+void JobsFree(JobPool *pool);
+
+//Threads that run jobs, the caller included.
+int JobsThreads(const JobPool *pool);
+
+//func(data, 0) ... func(data, count - 1), in any order and on any thread.
+void JobsRun(JobPool *pool, int count, JobFunc func, void *data);
+
+//******
+//JOB THREAD
+//One thread that runs a single job in the background while the caller does something else.
+//******
+struct JobThread
+{
+	std::thread *thread;
+
+	std::mutex              lock;
+	std::condition_variable wake;
+	std::condition_variable done;
+
+	JobFunc func;
+	void   *data;
+	bool    busy; //Job handed over and not finished.
+	bool    quit;
+};
+
+void JobThreadInit(JobThread *worker);
+
+void JobThreadFree(JobThread *worker);
+
+//Starts func(data, 0) on the thread, the previous job must have been waited for.
+void JobThreadStart(JobThread *worker, JobFunc func, void *data);
+
+//Returns when the started job is done, at once if there is none.
+void JobThreadWait(JobThread *worker);
@@ -1,9 +1,11 @@
 #ifndef DEFS_H
 #define DEFS_H
 
+#ifdef _MSC_VER
 #include <crtdbg.h>
+#endif
 
-#ifdef _DEBUG
+#if defined(_MSC_VER) && defined(_DEBUG)
 #define DBG_NEW new(1, __FILE__, __LINE__)
 #else
 #define DBG_NEW new
@@ -0,0 +1,169 @@
+#include "Pacer.h"
+
+#include <string.h>
+#include <thread>
+
+//******
+//Time helpers
+//******
+static inline double ElapsedMs(PacerClock::time_point from, PacerClock::time_point to)
+{
+	return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+static inline PacerClock::duration MsToDuration(double ms)
+{
+	return std::chrono::duration_cast<PacerClock::duration>(std::chrono::duration<double, std::milli>(ms));
+}
+
+//******
+//WaitUntil
+//Sleep is late by up to a timer period, so the last PACER_SPIN_MS is spun.
+//******
+static void WaitUntil(PacerClock::time_point until)
+{
+	const PacerClock::duration spin = MsToDuration(PACER_SPIN_MS);
+
+	const PacerClock::time_point now = PacerClock::now();
+	if (until - now > spin) std::this_thread::sleep_for(until - now - spin);
+
+	while (PacerClock::now() < until) std::this_thread::yield();
+}
+
+//******
+//PacerInit
+//******
+void PacerInit(Pacer *pacer, PaceMode mode, double rateHz)
+{
+	pacer->mode       = mode;
+	pacer->rateHz     = rateHz > 0 ? rateHz : 60.0;
+	pacer->intervalMs = 1000.0 / pacer->rateHz;
+
+	pacer->frameStart  = PacerClock::now();
+	pacer->deadline    = pacer->frameStart;
+	pacer->hasDeadline = false;
+
+	pacer->frames = 0;
+	pacer->missed = 0;
+
+	pacer->divisor       = 1;
+	pacer->windowFrames  = 0;
+	pacer->windowMissed  = 0;
+	pacer->windowWorstMs = 0;
+}
+
+//******
+//Adapt
+//******
+static void Adapt(Pacer *pacer, bool miss, double workMs)
+{
+	++pacer->windowFrames;
+	if (miss) ++pacer->windowMissed;
+	if (workMs > pacer->windowWorstMs) pacer->windowWorstMs = workMs;
+
+	if (pacer->windowFrames < PACER_ADAPT_FRAMES) return;
+
+	const double fasterMs = 1000.0 * (pacer->divisor - 1) / pacer->rateHz;
+	if (pacer->windowMissed > PACER_ADAPT_DOWN * pacer->windowFrames && pacer->divisor < PACER_MAX_DIVISOR)
+	{
+		++pacer->divisor;
+	}
+	else if (pacer->divisor > 1 && pacer->windowMissed == 0 && pacer->windowWorstMs < PACER_ADAPT_UP * fasterMs)
+	{
+		--pacer->divisor;
+	}
+	pacer->intervalMs = 1000.0 * pacer->divisor / pacer->rateHz;
+
+	pacer->windowFrames  = 0;
+	pacer->windowMissed  = 0;
+	pacer->windowWorstMs = 0;
+}
+
+//******
+//PacerFrameEnd
+//******
+void PacerFrameEnd(Pacer *pacer)
+{
+	const PacerClock::time_point now = PacerClock::now();
+	const double workMs = ElapsedMs(pacer->frameStart, now);
+	++pacer->frames;
+
+	if (pacer->mode == PACE_OFF)
+	{
+		pacer->frameStart = now;
+		return;
+	}
+
+	//Present waited for the display, a frame that took one and a half refresh has missed one.
+	if (pacer->mode == PACE_VSYNC)
+	{
+		if (pacer->hasDeadline && workMs > pacer->intervalMs * 1.5) ++pacer->missed;
+
+		pacer->hasDeadline = true;
+		pacer->frameStart  = now;
+		return;
+	}
+
+	const bool miss = pacer->hasDeadline && ElapsedMs(pacer->deadline, now) > PACER_MISS_MS;
+	if (miss) ++pacer->missed;
+
+	if (pacer->mode == PACE_ADAPTIVE) Adapt(pacer, miss, workMs);
+
+	//Late or first frame, start a new chain from now.
+	if (!pacer->hasDeadline || miss)
+	{
+		pacer->deadline    = now;
+		pacer->hasDeadline = true;
+	}
+	else
+	{
+		WaitUntil(pacer->deadline);
+	}
+
+	pacer->deadline  += MsToDuration(pacer->intervalMs);
+	pacer->frameStart = PacerClock::now();
+}
+
+//******
+//PacerIdle
+//******
+void PacerIdle(Pacer *pacer, double ms)
+{
+	if (pacer->mode == PACE_OFF) return;
+
+	WaitUntil(PacerClock::now() + MsToDuration(ms));
+
+	pacer->hasDeadline = false;
+	pacer->frameStart  = PacerClock::now();
+}
+
+//******
+//PacerParseMode
+//******
+bool PacerParseMode(const char *text, PaceMode *mode)
+{
+	for (int m = PACE_OFF; m <= PACE_ADAPTIVE; ++m)
+	{
+		if (strcmp(text, PacerModeName((PaceMode)m)) == 0)
+		{
+			*mode = (PaceMode)m;
+			return true;
+		}
+	}
+	return false;
+}
+
+//******
+//PacerModeName
+//******
+const char *PacerModeName(PaceMode mode)
+{
+	switch (mode)
+	{
+		case PACE_OFF:      return "off";
+		case PACE_VSYNC:    return "vsync";
+		case PACE_FIXED:    return "cap";
+		case PACE_ADAPTIVE: return "adaptive";
+	}
+	return "?";
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <chrono>
+
+//******
+//PACER
+//Keeps the game loop from drawing faster than it is useful. A frame has a deadline one frame interval
+//after the one before, the pacer sleeps until shortly before it and spins the rest. A frame that ends
+//after its deadline is a miss, the next deadline is then counted from now instead of catching up.
+//The sleep is only as good as the system timer, SDL asks Windows for 1 ms when it starts.
+//******
+
+enum PaceMode
+{
+	PACE_OFF = 0, //Draw as fast as possible, for benchmarks.
+	PACE_VSYNC,   //SDL_RenderPresent waits, the pacer only counts misses. main falls back to PACE_FIXED without vsync.
+	PACE_FIXED,   //Frame rate cap.
+	PACE_ADAPTIVE //Display rate, falls to a half, third... of it while frames miss and back when they fit.
+};
+
+typedef std::chrono::steady_clock PacerClock;
+
+struct Pacer
+{
+#define PACER_SPIN_MS 1.5 //Sleep until this close to the deadline, then spin.
+#define PACER_MISS_MS 0.5 //Slack before a frame counts as missed.
+
+#define PACER_ADAPT_FRAMES 120  //Frames between adaptive rate changes.
+#define PACER_ADAPT_DOWN   0.1  //Missed part of those frames that lowers the rate.
+#define PACER_ADAPT_UP     0.75 //Frames must have taken less than this part of the faster interval to raise it.
+#define PACER_MAX_DIVISOR  4
+
+	PaceMode mode;
+	double   rateHz;     //Cap, or the display rate for vsync and adaptive.
+	double   intervalMs; //Current frame interval.
+
+	PacerClock::time_point deadline;
+	PacerClock::time_point frameStart;
+	bool hasDeadline; //False after idling, the next frame starts a new chain.
+
+	int frames;
+	int missed;
+
+	//Adaptive, current rate is rateHz / divisor.
+	int    divisor;
+	int    windowFrames;
+	int    windowMissed;
+	double windowWorstMs; //Longest frame work in the window, sleep excluded.
+};
+
+void PacerInit(Pacer *pacer, PaceMode mode, double rateHz);
+
+//End of a drawn frame, after SDL_RenderPresent. Counts a miss and waits for the next deadline.
+void PacerFrameEnd(Pacer *pacer);
+
+//Nothing was drawn, sleep ms without counting a frame.
+void PacerIdle(Pacer *pacer, double ms);
+
+//Parses "vsync", "cap", "adaptive" or "off", false if it is none of them.
+bool PacerParseMode(const char *text, PaceMode *mode);
+
+const char *PacerModeName(PaceMode mode);
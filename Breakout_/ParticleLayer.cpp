@@ -0,0 +1,164 @@
+#include "ParticleLayer.h"
+
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LAYER_AVX2
+#define LAYER_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LAYER_SSE2
+#define LAYER_LANES 4
+#endif
+
+#define PARTICLE_PIXELS ((int)PARTICLE_SIZE)
+
+//Last pixel a particle can start at and still fit.
+#define LAYER_MAX_X (PARTICLE_LAYER_WIDTH  - PARTICLE_PIXELS)
+#define LAYER_MAX_Y (PARTICLE_LAYER_HEIGHT - PARTICLE_PIXELS)
+
+//******
+//ParticleLayerClear
+//******
+void ParticleLayerClear(ParticleLayer *layer)
+{
+	memset(layer->pixels, 0, sizeof(layer->pixels));
+	layer->rowBegin    = 0;
+	layer->rowEnd      = 0;
+	layer->uploadBegin = 0;
+	layer->uploadEnd   = PARTICLE_LAYER_HEIGHT;
+}
+
+//******
+//ParticleLayerPixel
+//Opaque whatever color.a is, DrawParticles fills with no blend mode and the layer must look the same.
+//******
+unsigned int ParticleLayerPixel(const Color &color)
+{
+	return 0xFF000000u | ((unsigned int)color.r << 16) | ((unsigned int)color.g << 8) | (unsigned int)color.b;
+}
+
+//******
+//PlotParticle
+//******
+static inline void PlotParticle(unsigned int *pixels, int at, unsigned int pixel)
+{
+	for (int y = 0; y != PARTICLE_PIXELS; ++y)
+	{
+		unsigned int *row = pixels + at + y * PARTICLE_LAYER_WIDTH;
+		for (int x = 0; x != PARTICLE_PIXELS; ++x)
+		{
+			row[x] = pixel;
+		}
+	}
+}
+
+//******
+//ParticleLayerDraw
+//******
+void ParticleLayerDraw(ParticleLayer *layer, const ParticlePool *pool, const unsigned int *palette)
+{
+	//Only rows that had particles last frame need clearing.
+	const int clearBegin = layer->rowBegin;
+	const int clearEnd   = layer->rowEnd;
+	if (clearEnd > clearBegin)
+	{
+		memset(layer->pixels + clearBegin * PARTICLE_LAYER_WIDTH, 0, (clearEnd - clearBegin) * PARTICLE_LAYER_WIDTH * sizeof(unsigned int));
+	}
+
+	int rowBegin = PARTICLE_LAYER_HEIGHT;
+	int rowEnd   = 0;
+
+	const int count = pool ? pool->count : 0;
+	int i = 0;
+
+#if defined(LAYER_AVX2) || defined(LAYER_SSE2)
+	//Bounds test and pixel offset LAYER_LANES particles at a time, offsets are below 2^24 so float math is exact.
+#if defined(LAYER_AVX2)
+	const __m256 zero  = _mm256_setzero_ps();
+	const __m256 maxX  = _mm256_set1_ps((float)LAYER_MAX_X + 1.0f);
+	const __m256 maxY  = _mm256_set1_ps((float)LAYER_MAX_Y + 1.0f);
+	const __m256 width = _mm256_set1_ps((float)PARTICLE_LAYER_WIDTH);
+#else
+	const __m128 zero  = _mm_setzero_ps();
+	const __m128 maxX  = _mm_set1_ps((float)LAYER_MAX_X + 1.0f);
+	const __m128 maxY  = _mm_set1_ps((float)LAYER_MAX_Y + 1.0f);
+	const __m128 width = _mm_set1_ps((float)PARTICLE_LAYER_WIDTH);
+#endif
+
+	for (; i + LAYER_LANES <= count; i += LAYER_LANES)
+	{
+		int at[LAYER_LANES];
+		int row[LAYER_LANES];
+
+#if defined(LAYER_AVX2)
+		const __m256 x = _mm256_loadu_ps(pool->posX + i);
+		const __m256 y = _mm256_loadu_ps(pool->posY + i);
+		const __m256 inside = _mm256_and_ps(
+			_mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_GE_OQ), _mm256_cmp_ps(x, maxX, _CMP_LT_OQ)),
+			_mm256_and_ps(_mm256_cmp_ps(y, zero, _CMP_GE_OQ), _mm256_cmp_ps(y, maxY, _CMP_LT_OQ)));
+		const int mask = _mm256_movemask_ps(inside);
+		if (mask == 0) continue;
+
+		//Lanes outside are zeroed so the conversion can not overflow.
+		const __m256i ix = _mm256_cvttps_epi32(_mm256_and_ps(x, inside));
+		const __m256i iy = _mm256_cvttps_epi32(_mm256_and_ps(y, inside));
+		const __m256  offset = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(iy), width), _mm256_cvtepi32_ps(ix));
+		_mm256_storeu_si256((__m256i *)at, _mm256_cvtps_epi32(offset));
+		_mm256_storeu_si256((__m256i *)row, iy);
+#else
+		const __m128 x = _mm_loadu_ps(pool->posX + i);
+		const __m128 y = _mm_loadu_ps(pool->posY + i);
+		const __m128 inside = _mm_and_ps(
+			_mm_and_ps(_mm_cmpge_ps(x, zero), _mm_cmplt_ps(x, maxX)),
+			_mm_and_ps(_mm_cmpge_ps(y, zero), _mm_cmplt_ps(y, maxY)));
+		const int mask = _mm_movemask_ps(inside);
+		if (mask == 0) continue;
+
+		const __m128i ix = _mm_cvttps_epi32(_mm_and_ps(x, inside));
+		const __m128i iy = _mm_cvttps_epi32(_mm_and_ps(y, inside));
+		const __m128  offset = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(iy), width), _mm_cvtepi32_ps(ix));
+		_mm_storeu_si128((__m128i *)at, _mm_cvtps_epi32(offset));
+		_mm_storeu_si128((__m128i *)row, iy);
+#endif
+
+		for (int lane = 0; lane != LAYER_LANES; ++lane)
+		{
+			if ((mask & (1 << lane)) == 0) continue;
+
+			PlotParticle(layer->pixels, at[lane], palette[pool->color[i + lane]]);
+			if (row[lane] < rowBegin) rowBegin = row[lane];
+			if (row[lane] >= rowEnd)  rowEnd   = row[lane] + 1;
+		}
+	}
+#endif
+
+	for (; i != count; ++i)
+	{
+		const float x = pool->posX[i];
+		const float y = pool->posY[i];
+		if (!(x >= 0 && x < LAYER_MAX_X + 1.0f && y >= 0 && y < LAYER_MAX_Y + 1.0f)) continue;
+
+		const int ix = (int)x;
+		const int iy = (int)y;
+		PlotParticle(layer->pixels, iy * PARTICLE_LAYER_WIDTH + ix, palette[pool->color[i]]);
+		if (iy < rowBegin) rowBegin = iy;
+		if (iy >= rowEnd)  rowEnd   = iy + 1;
+	}
+
+	if (rowEnd > 0) rowEnd += PARTICLE_PIXELS - 1;
+	else rowBegin = 0;
+
+	layer->rowBegin = rowBegin;
+	layer->rowEnd   = rowEnd;
+
+	//Cleared rows have to be uploaded too.
+	layer->uploadBegin = rowBegin;
+	layer->uploadEnd   = rowEnd;
+	if (clearEnd > clearBegin)
+	{
+		if (rowEnd == 0 || clearBegin < layer->uploadBegin) layer->uploadBegin = clearBegin;
+		if (clearEnd > layer->uploadEnd) layer->uploadEnd = clearEnd;
+	}
+}
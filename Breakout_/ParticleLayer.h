@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Particles.h"
+#include "Simulation.h"
+#include "Color.h"
+
+//******
+//PARTICLE LAYER
+//Every particle rasterized on the cpu into one window sized ARGB8888 buffer.
+//The caller uploads rows [uploadBegin, uploadEnd) to a streaming texture and draws it with one SDL_RenderCopy.
+//******
+
+struct ParticleLayer
+{
+#define PARTICLE_LAYER_WIDTH  WINDOW_WIDTH
+#define PARTICLE_LAYER_HEIGHT WINDOW_HEIGHT
+
+	unsigned int pixels[PARTICLE_LAYER_WIDTH * PARTICLE_LAYER_HEIGHT]; //0 is transparent.
+
+	//Rows with particles in them, cleared by the next draw.
+	int rowBegin;
+	int rowEnd;
+
+	//Rows that changed in the last draw, cleared or drawn.
+	int uploadBegin;
+	int uploadEnd;
+};
+
+void ParticleLayerClear(ParticleLayer *layer);
+
+//Clear last frames particles and draw pool, palette is indexed by the particle color.
+//pool can be NULL, the layer is then only cleared.
+void ParticleLayerDraw(ParticleLayer *layer, const ParticlePool *pool, const unsigned int *palette);
+
+//Color as an opaque ARGB8888 pixel, alpha is ignored.
+unsigned int ParticleLayerPixel(const Color &color);
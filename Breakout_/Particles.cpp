@@ -0,0 +1,497 @@
+#include "Particles.h"
+#include "Simulation.h"
+#include "Jobs.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PARTICLES_AVX2
+#define PARTICLE_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTICLES_SSE2
+#define PARTICLE_LANES 4
+#endif
+
+//******
+//ParticlesClear
+//******
+void ParticlesClear(ParticlePool *pool)
+{
+	pool->count = 0;
+}
+
+//******
+//ParticlesSpawn
+//******
+bool ParticlesSpawn(ParticlePool *pool, const Vec2 &pos, const Vec2 &vel, const Vec2 &acc, int color)
+{
+	if (pool->count == MAX_PARTICLES) return false;
+
+	const int i = pool->count++;
+	pool->posX[i]  = pos.x;
+	pool->posY[i]  = pos.y;
+	pool->velX[i]  = vel.x;
+	pool->velY[i]  = vel.y;
+	pool->accX[i]  = acc.x;
+	pool->accY[i]  = acc.y;
+	pool->color[i] = (unsigned char)color;
+	return true;
+}
+
+//******
+//MoveParticle
+//Particle read to slot write, write is never after read.
+//******
+static inline void MoveParticle(ParticlePool *pool, int read, int write, float x, float y, float velY)
+{
+	pool->posX[write]  = x;
+	pool->posY[write]  = y;
+	pool->velX[write]  = pool->velX[read];
+	pool->velY[write]  = velY;
+	pool->accX[write]  = pool->accX[read];
+	pool->accY[write]  = pool->accY[read];
+	pool->color[write] = pool->color[read];
+}
+
+//******
+//UpdateRange
+//Scalar update of particles [read, end), the ones still inside are packed from write.
+//Returns the new write position.
+//******
+static int UpdateRange(ParticlePool *pool, int read, int end, int write, float deltaVel, float accScale)
+{
+	for (; read != end; ++read)
+	{
+		const float x = pool->posX[read] + (pool->velX[read] + accScale * pool->accX[read]);
+		const float y = pool->posY[read] + (pool->velY[read] + accScale * pool->accY[read]);
+
+		//Left the window.
+		if ((x + PARTICLE_SIZE) >= WINDOW_WIDTH  || x <= 0 ||
+			(y + PARTICLE_SIZE) >= WINDOW_HEIGHT || y <= 0)
+		{
+			continue;
+		}
+
+		MoveParticle(pool, read, write, x, y, pool->velY[read] + deltaVel);
+		++write;
+	}
+	return write;
+}
+
+//******
+//ParticlesUpdateScalar
+//******
+void ParticlesUpdateScalar(ParticlePool *pool, float delta)
+{
+	const float deltaVel = delta * GRAVITY / 1000;
+	const float accScale = (deltaVel / 2) * delta;
+
+	pool->count = UpdateRange(pool, 0, pool->count, 0, deltaVel, accScale);
+}
+
+//******
+//ParticlesInterpolate
+//The last update moved a particle by its velocity before gravity plus accScale * acc, step back part of that.
+//******
+void ParticlesInterpolate(const ParticlePool *pool, float delta, float alpha, ParticlePool *out)
+{
+	const float deltaVel = delta * GRAVITY / 1000;
+	const float accScale = (deltaVel / 2) * delta;
+	const float back     = 1.0f - alpha;
+
+	const int count = pool->count;
+	for (int i = 0; i != count; ++i)
+	{
+		out->posX[i] = pool->posX[i] - back * (pool->velX[i] + accScale * pool->accX[i]);
+		out->posY[i] = pool->posY[i] - back * ((pool->velY[i] - deltaVel) + accScale * pool->accY[i]);
+	}
+	memcpy(out->color, pool->color, count);
+	out->count = count;
+}
+
+#if defined(PARTICLES_AVX2) || defined(PARTICLES_SSE2)
+
+#if defined(PARTICLES_AVX2)
+typedef __m256 Lanes;
+#define LanesLoad(p)         _mm256_loadu_ps(p)
+#define LanesStore(p, v)     _mm256_storeu_ps(p, v)
+#define LanesSet(f)          _mm256_set1_ps(f)
+#define LanesAdd(a, b)       _mm256_add_ps(a, b)
+#define LanesMul(a, b)       _mm256_mul_ps(a, b)
+#define LanesGreater(a, b)   _mm256_cmp_ps(a, b, _CMP_GT_OQ)
+#define LanesLess(a, b)      _mm256_cmp_ps(a, b, _CMP_LT_OQ)
+#define LanesAnd(a, b)       _mm256_and_ps(a, b)
+#define LanesMask(v)         _mm256_movemask_ps(v)
+#else
+typedef __m128 Lanes;
+#define LanesLoad(p)         _mm_loadu_ps(p)
+#define LanesStore(p, v)     _mm_storeu_ps(p, v)
+#define LanesSet(f)          _mm_set1_ps(f)
+#define LanesAdd(a, b)       _mm_add_ps(a, b)
+#define LanesMul(a, b)       _mm_mul_ps(a, b)
+#define LanesGreater(a, b)   _mm_cmpgt_ps(a, b)
+#define LanesLess(a, b)      _mm_cmplt_ps(a, b)
+#define LanesAnd(a, b)       _mm_and_ps(a, b)
+#define LanesMask(v)         _mm_movemask_ps(v)
+#endif
+
+#define ALL_LANES ((1 << PARTICLE_LANES) - 1)
+
+//******
+//UpdateBlock
+//Particles [begin, end), the ones still inside are packed from begin. Returns where they end.
+//PARTICLE_LANES particles per step. A step where every particle stayed inside is stored whole,
+//otherwise only the lanes in the mask are copied down.
+//******
+static int UpdateBlock(ParticlePool *pool, int begin, int end, float deltaVel, float accScale)
+{
+	const Lanes vDeltaVel = LanesSet(deltaVel);
+	const Lanes vAccScale = LanesSet(accScale);
+	const Lanes vSize     = LanesSet(PARTICLE_SIZE);
+	const Lanes vWidth    = LanesSet(WINDOW_WIDTH);
+	const Lanes vHeight   = LanesSet(WINDOW_HEIGHT);
+	const Lanes vZero     = LanesSet(0.0f);
+
+	int read  = begin;
+	int write = begin;
+	for (; read + PARTICLE_LANES <= end; read += PARTICLE_LANES)
+	{
+		const Lanes velY = LanesLoad(pool->velY + read);
+		const Lanes x = LanesAdd(LanesLoad(pool->posX + read), LanesAdd(LanesLoad(pool->velX + read), LanesMul(vAccScale, LanesLoad(pool->accX + read))));
+		const Lanes y = LanesAdd(LanesLoad(pool->posY + read), LanesAdd(velY, LanesMul(vAccScale, LanesLoad(pool->accY + read))));
+
+		const Lanes inside = LanesAnd(
+			LanesAnd(LanesGreater(x, vZero), LanesLess(LanesAdd(x, vSize), vWidth)),
+			LanesAnd(LanesGreater(y, vZero), LanesLess(LanesAdd(y, vSize), vHeight)));
+		const int mask = LanesMask(inside);
+
+		if (mask == ALL_LANES)
+		{
+			LanesStore(pool->posX + write, x);
+			LanesStore(pool->posY + write, y);
+			LanesStore(pool->velY + write, LanesAdd(velY, vDeltaVel));
+			if (write != read)
+			{
+				memmove(pool->velX + write, pool->velX + read, PARTICLE_LANES * sizeof(float));
+				memmove(pool->accX + write, pool->accX + read, PARTICLE_LANES * sizeof(float));
+				memmove(pool->accY + write, pool->accY + read, PARTICLE_LANES * sizeof(float));
+				memmove(pool->color + write, pool->color + read, PARTICLE_LANES);
+			}
+			write += PARTICLE_LANES;
+		}
+		else if (mask != 0)
+		{
+			float newX[PARTICLE_LANES], newY[PARTICLE_LANES], newVelY[PARTICLE_LANES];
+			LanesStore(newX, x);
+			LanesStore(newY, y);
+			LanesStore(newVelY, LanesAdd(velY, vDeltaVel));
+
+			for (int lane = 0; lane != PARTICLE_LANES; ++lane)
+			{
+				if (mask & (1 << lane))
+				{
+					MoveParticle(pool, read + lane, write, newX[lane], newY[lane], newVelY[lane]);
+					++write;
+				}
+			}
+		}
+	}
+
+	return UpdateRange(pool, read, end, write, deltaVel, accScale);
+}
+
+#else
+
+//******
+//UpdateBlock
+//No SIMD on this target.
+//******
+static int UpdateBlock(ParticlePool *pool, int begin, int end, float deltaVel, float accScale)
+{
+	return UpdateRange(pool, begin, end, begin, deltaVel, accScale);
+}
+
+#endif
+
+//******
+//ParticlesUpdate
+//******
+void ParticlesUpdate(ParticlePool *pool, float delta)
+{
+	const float deltaVel = delta * GRAVITY / 1000;
+	const float accScale = (deltaVel / 2) * delta;
+
+	pool->count = UpdateBlock(pool, 0, pool->count, deltaVel, accScale);
+}
+
+//******
+//PARALLEL UPDATE
+//Chunks are fixed size, not per thread, so the result is the same for any thread count.
+//******
+#define MAX_PARTICLE_CHUNKS ((MAX_PARTICLES + PARTICLE_CHUNK - 1) / PARTICLE_CHUNK)
+
+struct ParticleChunks
+{
+	ParticlePool *pool;
+	int   count;
+	float deltaVel;
+	float accScale;
+	int   end[MAX_PARTICLE_CHUNKS]; //Where the packed particles of each chunk end.
+};
+
+//******
+//UpdateChunk
+//******
+static void UpdateChunk(void *data, int chunk)
+{
+	ParticleChunks *chunks = (ParticleChunks *)data;
+
+	const int begin = chunk * PARTICLE_CHUNK;
+	const int end   = begin + PARTICLE_CHUNK < chunks->count ? begin + PARTICLE_CHUNK : chunks->count;
+	chunks->end[chunk] = UpdateBlock(chunks->pool, begin, end, chunks->deltaVel, chunks->accScale);
+}
+
+//******
+//MoveParticles
+//******
+static void MoveParticles(ParticlePool *pool, int from, int to, int count)
+{
+	memmove(pool->posX + to, pool->posX + from, count * sizeof(float));
+	memmove(pool->posY + to, pool->posY + from, count * sizeof(float));
+	memmove(pool->velX + to, pool->velX + from, count * sizeof(float));
+	memmove(pool->velY + to, pool->velY + from, count * sizeof(float));
+	memmove(pool->accX + to, pool->accX + from, count * sizeof(float));
+	memmove(pool->accY + to, pool->accY + from, count * sizeof(float));
+	memmove(pool->color + to, pool->color + from, count);
+}
+
+//******
+//ParticlesUpdateJobs
+//******
+void ParticlesUpdateJobs(ParticlePool *pool, float delta, JobPool *jobs)
+{
+	const int numChunks = (pool->count + PARTICLE_CHUNK - 1) / PARTICLE_CHUNK;
+	if (!jobs || numChunks <= 1)
+	{
+		ParticlesUpdate(pool, delta);
+		return;
+	}
+
+	ParticleChunks chunks;
+	chunks.pool     = pool;
+	chunks.count    = pool->count;
+	chunks.deltaVel = delta * GRAVITY / 1000;
+	chunks.accScale = (chunks.deltaVel / 2) * delta;
+
+	JobsRun(jobs, numChunks, UpdateChunk, &chunks);
+
+	//Close the gaps between chunks, in order.
+	int write = chunks.end[0];
+	for (int chunk = 1; chunk != numChunks; ++chunk)
+	{
+		const int begin = chunk * PARTICLE_CHUNK;
+		const int kept  = chunks.end[chunk] - begin;
+		if (write != begin && kept > 0) MoveParticles(pool, begin, write, kept);
+		write += kept;
+	}
+	pool->count = write;
+}
+
+//******
+//TrailX, TrailY
+//Position n ticks after spawn.
+//******
+static inline float TrailX(const ParticleTrails *trails, int i, int n)
+{
+	return trails->startX[i] + (float)n * trails->stepX[i];
+}
+
+static inline float TrailY(const ParticleTrails *trails, int i, int n)
+{
+	return trails->startY[i] + (float)n * trails->stepY[i] + trails->fallStep * (float)((n * (n - 1)) / 2);
+}
+
+static inline bool TrailOutside(const ParticleTrails *trails, int i, int n)
+{
+	const float x = TrailX(trails, i, n);
+	const float y = TrailY(trails, i, n);
+	return (x + PARTICLE_SIZE) >= WINDOW_WIDTH || x <= 0 || (y + PARTICLE_SIZE) >= WINDOW_HEIGHT || y <= 0;
+}
+
+//******
+//TrailXAt, TrailYAt
+//Same at a fraction of a tick.
+//******
+static inline float TrailXAt(const ParticleTrails *trails, int i, float t)
+{
+	return trails->startX[i] + t * trails->stepX[i];
+}
+
+static inline float TrailYAt(const ParticleTrails *trails, int i, float t)
+{
+	return trails->startY[i] + t * trails->stepY[i] + trails->fallStep * (t * (t - 1.0f) / 2);
+}
+
+//******
+//TrailLife
+//Ticks until particle i is first outside the window, at least 1.
+//x is a line and y a parabola opening down the screen, each boundary is a root. The guess is then
+//moved to where TrailOutside agrees, so rounding can not make a particle pop in or out.
+//******
+static int TrailLife(const ParticleTrails *trails, int i)
+{
+	const double x0 = trails->startX[i];
+	const double y0 = trails->startY[i];
+	const double sx = trails->stepX[i];
+	const double a  = trails->fallStep / 2.0;
+	const double b  = trails->stepY[i] - a;
+	const double right  = WINDOW_WIDTH - PARTICLE_SIZE;
+	const double bottom = WINDOW_HEIGHT - PARTICLE_SIZE;
+
+	double life = PARTICLE_MAX_LIFE;
+
+	//Left or right side.
+	if (sx > 0)      life = fmin(life, (right - x0) / sx);
+	else if (sx < 0) life = fmin(life, -x0 / sx);
+
+	//Bottom, a * n^2 + b * n + y0 = bottom.
+	if (a > 0)
+	{
+		const double disc = b * b - 4.0 * a * (y0 - bottom);
+		if (disc >= 0) life = fmin(life, (-b + sqrt(disc)) / (2.0 * a));
+
+		//Top, y is at or above 0 between the roots.
+		const double discTop = b * b - 4.0 * a * y0;
+		if (discTop >= 0)
+		{
+			const double first = fmax(1.0, ceil((-b - sqrt(discTop)) / (2.0 * a)));
+			if (first <= (-b + sqrt(discTop)) / (2.0 * a)) life = fmin(life, first);
+		}
+	}
+
+	int n = life < 1.0 ? 1 : (int)ceil(life);
+	if (n > PARTICLE_MAX_LIFE) n = PARTICLE_MAX_LIFE;
+
+	while (n > 1 && TrailOutside(trails, i, n - 1)) --n;
+	while (n < PARTICLE_MAX_LIFE && !TrailOutside(trails, i, n)) ++n;
+	return n;
+}
+
+//******
+//ParticleTrailsClear
+//******
+void ParticleTrailsClear(ParticleTrails *trails)
+{
+	trails->count     = 0;
+	trails->tick      = 0;
+	trails->droppedAt = -1;
+	trails->fallStep  = TIME_STEP * GRAVITY / 1000;
+}
+
+//******
+//MoveTrail
+//******
+static inline void MoveTrail(ParticleTrails *trails, int read, int write)
+{
+	trails->startX[write]    = trails->startX[read];
+	trails->startY[write]    = trails->startY[read];
+	trails->stepX[write]     = trails->stepX[read];
+	trails->stepY[write]     = trails->stepY[read];
+	trails->spawnTick[write] = trails->spawnTick[read];
+	trails->endTick[write]   = trails->endTick[read];
+	trails->color[write]     = trails->color[read];
+}
+
+//******
+//DropEndedTrails
+//******
+static void DropEndedTrails(ParticleTrails *trails)
+{
+	int write = 0;
+	for (int read = 0; read != trails->count; ++read)
+	{
+		if (trails->tick >= trails->endTick[read]) continue;
+
+		if (write != read) MoveTrail(trails, read, write);
+		++write;
+	}
+	trails->count     = write;
+	trails->droppedAt = trails->tick;
+}
+
+//******
+//ParticleTrailsLive
+//******
+int ParticleTrailsLive(const ParticleTrails *trails)
+{
+	int live = 0;
+	for (int i = 0; i != trails->count; ++i) live += trails->tick < trails->endTick[i];
+	return live;
+}
+
+//******
+//ParticleTrailsSpawn
+//******
+bool ParticleTrailsSpawn(ParticleTrails *trails, const Vec2 &pos, const Vec2 &vel, const Vec2 &acc, int color)
+{
+	if (trails->count == MAX_PARTICLES && trails->droppedAt != trails->tick) DropEndedTrails(trails);
+	if (trails->count == MAX_PARTICLES) return false;
+
+	//Same terms as UpdateRange with a TIME_STEP delta.
+	const float accScale = (trails->fallStep / 2) * TIME_STEP;
+
+	const int i = trails->count++;
+	trails->startX[i]    = pos.x;
+	trails->startY[i]    = pos.y;
+	trails->stepX[i]     = vel.x + accScale * acc.x;
+	trails->stepY[i]     = vel.y + accScale * acc.y;
+	trails->spawnTick[i] = trails->tick;
+	trails->color[i]     = (unsigned char)color;
+	trails->endTick[i]   = trails->tick + TrailLife(trails, i);
+	return true;
+}
+
+//******
+//ParticleTrailsTick
+//******
+void ParticleTrailsTick(ParticleTrails *trails)
+{
+	++trails->tick;
+}
+
+//******
+//ParticleTrailsEvaluate
+//******
+void ParticleTrailsEvaluate(ParticleTrails *trails, ParticlePool *out, float alpha)
+{
+	const int tick = trails->tick;
+	const float back = 1.0f - alpha;
+
+	int write = 0;
+	for (int read = 0; read != trails->count; ++read)
+	{
+		if (tick >= trails->endTick[read]) continue;
+
+		if (write != read) MoveTrail(trails, read, write);
+
+		const int n = tick - trails->spawnTick[write];
+		if (back > 0 && n > 0)
+		{
+			out->posX[write] = TrailXAt(trails, write, n - back);
+			out->posY[write] = TrailYAt(trails, write, n - back);
+		}
+		else
+		{
+			out->posX[write] = TrailX(trails, write, n);
+			out->posY[write] = TrailY(trails, write, n);
+		}
+		out->color[write] = trails->color[write];
+		++write;
+	}
+	trails->count     = write;
+	trails->droppedAt = tick;
+	out->count        = write;
+}
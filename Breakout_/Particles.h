@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Vector.h"
+
+//******
+//PARTICLES
+//One pool for every splitter in the game, structure of arrays.
+//Live particles are packed at the front. ParticlesUpdate moves 8 (AVX2) or 4 (SSE2) at a time
+//and packs the ones still inside the window down over the ones that left.
+//******
+
+#define GRAVITY 9.80
+
+struct JobPool;
+
+struct ParticlePool
+{
+#define MAX_PARTICLES (128 * 1024)
+#define PARTICLE_SIZE 2.0f
+#define PARTICLE_CHUNK (8 * 1024) //Particles per job in ParticlesUpdateJobs.
+
+	float posX[MAX_PARTICLES];
+	float posY[MAX_PARTICLES];
+	float velX[MAX_PARTICLES];
+	float velY[MAX_PARTICLES];
+	float accX[MAX_PARTICLES];
+	float accY[MAX_PARTICLES];
+	unsigned char color[MAX_PARTICLES]; //Index in the owners palette.
+	int   count;
+};
+
+void ParticlesClear(ParticlePool *pool);
+
+//Returns false if the pool is full, the particle is dropped.
+bool ParticlesSpawn(ParticlePool *pool, const Vec2 &pos, const Vec2 &vel, const Vec2 &acc, int color);
+
+//Move every particle, remove the ones outside the window.
+void ParticlesUpdate(ParticlePool *pool, float delta);
+
+//Same as ParticlesUpdate split in PARTICLE_CHUNK jobs over jobs, NULL runs on the caller.
+//Gives the same pool as ParticlesUpdate for any number of threads.
+void ParticlesUpdateJobs(ParticlePool *pool, float delta, JobPool *jobs);
+
+//Same as ParticlesUpdate one particle at a time, reference for the SIMD path.
+void ParticlesUpdateScalar(ParticlePool *pool, float delta);
+
+//Positions and colors alpha of the way from before the last update (0) to now (1) into out.
+//delta is the one the last update was given. Velocities in out are not set.
+void ParticlesInterpolate(const ParticlePool *pool, float delta, float alpha, ParticlePool *out);
+
+//******
+//PARTICLE TRAILS
+//Same motion as ParticlePool stepped with TIME_STEP, but in closed form. Only the spawn tick and
+//start values are stored, positions are worked out when asked for and a tick is just a counter.
+//The tick a particle leaves the window is solved for at spawn.
+//******
+struct ParticleTrails
+{
+#define PARTICLE_MAX_LIFE (60 * 60) //Ticks, a particle that never leaves is dropped after this.
+
+	float startX[MAX_PARTICLES];
+	float startY[MAX_PARTICLES];
+	float stepX[MAX_PARTICLES]; //Per tick, acceleration included.
+	float stepY[MAX_PARTICLES]; //Per tick at spawn, gravity adds fallStep every tick.
+	int   spawnTick[MAX_PARTICLES];
+	int   endTick[MAX_PARTICLES]; //First tick the particle is outside the window.
+	unsigned char color[MAX_PARTICLES];
+	int   count;
+
+	int   tick;
+	int   droppedAt; //Tick the ended trails were last dropped, a full pool is only swept once per tick.
+	float fallStep;
+};
+
+void ParticleTrailsClear(ParticleTrails *trails);
+
+//Returns false if full even after dropping the particles that have left.
+bool ParticleTrailsSpawn(ParticleTrails *trails, const Vec2 &pos, const Vec2 &vel, const Vec2 &acc, int color);
+
+//One TIME_STEP.
+void ParticleTrailsTick(ParticleTrails *trails);
+
+//Trails still inside the window, count also holds ended ones until they are dropped.
+int ParticleTrailsLive(const ParticleTrails *trails);
+
+//Positions and colors into out, alpha of the way from the tick before (0) to the current tick (1).
+//The particles that have left are dropped. Velocities in out are not set.
+void ParticleTrailsEvaluate(ParticleTrails *trails, ParticlePool *out, float alpha);
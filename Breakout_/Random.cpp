@@ -0,0 +1,102 @@
+#include "Random.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define RANDOM_AVX2
+#define RANDOM_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RANDOM_SSE2
+#define RANDOM_LANES 4
+#endif
+
+#define RNG_MULTIPLIER 6364136223846793005ULL
+
+//24 random bits to a float in [0, 1).
+#define RNG_FLOAT_SCALE (1.0f / 16777216.0f)
+
+//******
+//RngSeed
+//******
+void RngSeed(Rng *rng, unsigned long long seed, unsigned long long stream)
+{
+	rng->state = 0;
+	rng->inc   = (stream << 1) | 1;
+	RngNext(rng);
+	rng->state += seed;
+	RngNext(rng);
+}
+
+//******
+//RngNext
+//******
+unsigned int RngNext(Rng *rng)
+{
+	const unsigned long long old = rng->state;
+	rng->state = old * RNG_MULTIPLIER + rng->inc;
+
+	const unsigned int xorShifted = (unsigned int)(((old >> 18) ^ old) >> 27);
+	const unsigned int rot        = (unsigned int)(old >> 59);
+	return (xorShifted >> rot) | (xorShifted << ((32 - rot) & 31));
+}
+
+//******
+//RngInt
+//Multiply and keep the high half, no modulo.
+//******
+int RngInt(Rng *rng, int n)
+{
+	return (int)(((unsigned long long)RngNext(rng) * (unsigned int)n) >> 32);
+}
+
+//******
+//RngRange
+//******
+float RngRange(Rng *rng, float min, float max)
+{
+	const float scale = (max - min) * RNG_FLOAT_SCALE;
+	return min + (float)(RngNext(rng) >> 8) * scale;
+}
+
+//******
+//RngFill
+//******
+void RngFill(Rng *rng, unsigned int *out, int count)
+{
+	for (int i = 0; i != count; ++i)
+	{
+		out[i] = RngNext(rng);
+	}
+}
+
+//******
+//RngFillRange
+//******
+void RngFillRange(Rng *rng, float *out, int count, float min, float max)
+{
+	const float scale = (max - min) * RNG_FLOAT_SCALE;
+	int i = 0;
+
+#if defined(RANDOM_AVX2) || defined(RANDOM_SSE2)
+	unsigned int bits[RANDOM_LANES];
+	for (; i + RANDOM_LANES <= count; i += RANDOM_LANES)
+	{
+		RngFill(rng, bits, RANDOM_LANES);
+
+#if defined(RANDOM_AVX2)
+		const __m256i top = _mm256_srli_epi32(_mm256_loadu_si256((const __m256i *)bits), 8);
+		const __m256  val = _mm256_add_ps(_mm256_set1_ps(min), _mm256_mul_ps(_mm256_cvtepi32_ps(top), _mm256_set1_ps(scale)));
+		_mm256_storeu_ps(out + i, val);
+#else
+		const __m128i top = _mm_srli_epi32(_mm_loadu_si128((const __m128i *)bits), 8);
+		const __m128  val = _mm_add_ps(_mm_set1_ps(min), _mm_mul_ps(_mm_cvtepi32_ps(top), _mm_set1_ps(scale)));
+		_mm_storeu_ps(out + i, val);
+#endif
+	}
+#endif
+
+	for (; i != count; ++i)
+	{
+		out[i] = min + (float)(RngNext(rng) >> 8) * scale;
+	}
+}
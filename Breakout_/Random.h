@@ -0,0 +1,35 @@
+#pragma once
+
+//******
+//RANDOM
+//PCG32, 64 bit state and a stream selector. Every system owns its Rng and draws from its own
+//stream, so there is no global state and extra draws in one system never shift another.
+//The same seed and stream always give the same numbers, on every compiler.
+//******
+
+//Streams
+#define RNG_STREAM_BLOCKS  1
+#define RNG_STREAM_EFFECTS 2
+#define RNG_STREAM_BENCH   3
+
+struct Rng
+{
+	unsigned long long state;
+	unsigned long long inc; //Odd, picks the stream.
+};
+
+void RngSeed(Rng *rng, unsigned long long seed, unsigned long long stream);
+
+unsigned int RngNext(Rng *rng);
+
+//0 to n - 1, n > 0.
+int RngInt(Rng *rng, int n);
+
+//min to max, max not included.
+float RngRange(Rng *rng, float min, float max);
+
+//count numbers, same as count RngNext.
+void RngFill(Rng *rng, unsigned int *out, int count);
+
+//count RngRange(rng, min, max), converted 4 (SSE2) or 8 (AVX2) at a time.
+void RngFillRange(Rng *rng, float *out, int count, float min, float max);
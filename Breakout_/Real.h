@@ -0,0 +1,153 @@
+#pragma once
+
+#include "Vector.h"
+
+#include <float.h>
+#include <limits.h>
+
+//******
+//REAL
+//Number type of the simulation state (ball, paddle, blocks).
+//float by default. Define SIM_FIXED_POINT to build the simulation on 16.16 fixed point instead,
+//then every tick is integer math and gives the same bits on every compiler and flag set.
+//******
+
+#ifdef SIM_FIXED_POINT
+
+struct Fixed
+{
+#define FIXED_SHIFT 16
+#define FIXED_ONE   (1 << FIXED_SHIFT)
+
+	Fixed()
+	{
+		raw = 0;
+	}
+
+	Fixed(int val)
+	{
+		raw = val * FIXED_ONE;
+	}
+
+	//Constants only, rounded to nearest.
+	Fixed(double val)
+	{
+		const double scaled = val * FIXED_ONE;
+		raw = (int)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+	}
+
+	Fixed(float val)
+	{
+		*this = Fixed((double)val);
+	}
+
+	static Fixed FromRaw(long long val)
+	{
+		//Saturate, a division by a tiny velocity must not wrap around.
+		if (val > INT_MAX) val = INT_MAX;
+		if (val < -INT_MAX) val = -INT_MAX;
+
+		Fixed f;
+		f.raw = (int)val;
+		return f;
+	}
+
+	Fixed operator-() const { return FromRaw(-(long long)raw); }
+
+	Fixed &operator+=(const Fixed &v) { return *this = *this + v; }
+	Fixed &operator-=(const Fixed &v) { return *this = *this - v; }
+	Fixed &operator*=(const Fixed &v) { return *this = *this * v; }
+	Fixed &operator/=(const Fixed &v) { return *this = *this / v; }
+
+	//Free functions so ints and constants convert on either side.
+	friend Fixed operator+(const Fixed &a, const Fixed &b) { return FromRaw((long long)a.raw + b.raw); }
+	friend Fixed operator-(const Fixed &a, const Fixed &b) { return FromRaw((long long)a.raw - b.raw); }
+	friend Fixed operator*(const Fixed &a, const Fixed &b) { return FromRaw(((long long)a.raw * b.raw) >> FIXED_SHIFT); }
+	friend Fixed operator/(const Fixed &a, const Fixed &b)
+	{
+		if (b.raw == 0) return FromRaw(a.raw < 0 ? -(long long)INT_MAX : INT_MAX);
+		return FromRaw(((long long)a.raw * FIXED_ONE) / b.raw);
+	}
+
+	friend bool operator==(const Fixed &a, const Fixed &b) { return a.raw == b.raw; }
+	friend bool operator!=(const Fixed &a, const Fixed &b) { return a.raw != b.raw; }
+	friend bool operator< (const Fixed &a, const Fixed &b) { return a.raw <  b.raw; }
+	friend bool operator> (const Fixed &a, const Fixed &b) { return a.raw >  b.raw; }
+	friend bool operator<=(const Fixed &a, const Fixed &b) { return a.raw <= b.raw; }
+	friend bool operator>=(const Fixed &a, const Fixed &b) { return a.raw >= b.raw; }
+
+	int raw;
+};
+
+typedef Fixed Real;
+
+struct RealVec2
+{
+	RealVec2() {}
+
+	RealVec2(Real x, Real y)
+	{
+		this->x = x;
+		this->y = y;
+	}
+
+	void operator+=(const RealVec2 &v)
+	{
+		x += v.x;
+		y += v.y;
+	}
+
+	RealVec2 operator+(const RealVec2 &v) const
+	{
+		return RealVec2(x + v.x, y + v.y);
+	}
+
+	RealVec2 operator-(const RealVec2 &v) const
+	{
+		return RealVec2(x - v.x, y - v.y);
+	}
+
+	//Scalars
+	RealVec2 operator*(Real val) const
+	{
+		return RealVec2(x * val, y * val);
+	}
+
+	Real DotProduct(const RealVec2 &v) const
+	{
+		return (x * v.x) + (y * v.y);
+	}
+
+	Real x;
+	Real y;
+};
+
+#define REAL_MAX Fixed::FromRaw(INT_MAX)
+
+inline Real  RealAbs(Real val)       { return val < 0 ? -val : val; }
+inline int   RealFloor(Real val)     { return val.raw >> FIXED_SHIFT; }
+inline float RealToFloat(Real val)   { return (float)val.raw / FIXED_ONE; }
+inline unsigned RealBits(Real val)   { return (unsigned)val.raw; }
+
+inline Vec2 RealToVec2(const RealVec2 &v) { return Vec2(RealToFloat(v.x), RealToFloat(v.y)); }
+
+#else
+
+typedef float Real;
+typedef Vec2  RealVec2;
+
+#define REAL_MAX FLT_MAX
+
+inline Real  RealAbs(Real val)     { return fabsf(val); }
+inline int   RealFloor(Real val)   { return (int)floorf(val); }
+inline float RealToFloat(Real val) { return val; }
+inline unsigned RealBits(Real val)
+{
+	union { float f; unsigned u; } bits;
+	bits.f = val;
+	return bits.u;
+}
+
+inline Vec2 RealToVec2(const RealVec2 &v) { return v; }
+
+#endif
@@ -0,0 +1,272 @@
+#include "Replay.h"
+#include "MemAlloc.h"
+
+#include <chrono>
+#include <string.h>
+
+#define REPLAY_LEVEL 0xff
+#define REPLAY_END   0xfe
+
+#define REPLAY_HEADER_SIZE 22 //magic 4, version 1, flags 1, seed 4, ticks 4, hash 8.
+#define REPLAY_TICKS_AT    10
+
+//******
+//Write helpers
+//******
+static void WriteU32(FILE *file, unsigned int val)
+{
+	const unsigned char bytes[4] = { (unsigned char)val, (unsigned char)(val >> 8), (unsigned char)(val >> 16), (unsigned char)(val >> 24) };
+	fwrite(bytes, 1, 4, file);
+}
+
+static void WriteVarint(FILE *file, unsigned int val)
+{
+	while (val >= 0x80)
+	{
+		fputc((int)(val & 0x7f) | 0x80, file);
+		val >>= 7;
+	}
+	fputc((int)val, file);
+}
+
+//******
+//Read helpers
+//Reads past end return 0 and set *ok to false.
+//******
+struct ReplayReader
+{
+	const unsigned char *data;
+	int size;
+	int at;
+	bool ok;
+};
+
+static int ReadByte(ReplayReader *r)
+{
+	if (r->at >= r->size)
+	{
+		r->ok = false;
+		return 0;
+	}
+	return r->data[r->at++];
+}
+
+static unsigned int ReadU32(ReplayReader *r)
+{
+	unsigned int val = 0;
+	for (int i = 0; i != 4; ++i) val |= (unsigned int)ReadByte(r) << (i * 8);
+	return val;
+}
+
+static unsigned int ReadVarint(ReplayReader *r)
+{
+	unsigned int val = 0;
+	for (int shift = 0; shift < 32; shift += 7)
+	{
+		const int b = ReadByte(r);
+		val |= (unsigned int)(b & 0x7f) << shift;
+		if ((b & 0x80) == 0) return val;
+	}
+	r->ok = false;
+	return 0;
+}
+
+//******
+//InputByte
+//******
+static int InputToByte(const SimInput *input)
+{
+	return (input->fireBall ? 1 : 0) | ((input->moveDir + 1) << 1);
+}
+
+static SimInput ByteToInput(int b)
+{
+	SimInput input;
+	input.fireBall = (b & 1) != 0;
+	input.moveDir  = ((b >> 1) & 3) - 1;
+	return input;
+}
+
+//******
+//FlushRun
+//******
+static void FlushRun(ReplayRecorder *rec)
+{
+	if (rec->runLength == 0) return;
+
+	fputc(rec->runInput, rec->file);
+	WriteVarint(rec->file, rec->runLength);
+	rec->runLength = 0;
+}
+
+//******
+//ReplayBeginRecord
+//******
+bool ReplayBeginRecord(ReplayRecorder *rec, const char *path, const SimState *s, unsigned int seed)
+{
+	rec->file      = fopen(path, "wb");
+	rec->runInput  = 0;
+	rec->runLength = 0;
+	rec->ticks     = 0;
+
+	if (!rec->file) return false;
+
+	int flags = 0;
+	if (s->multiBall) flags |= REPLAY_FLAG_MULTIBALL;
+#ifdef SIM_FIXED_POINT
+	flags |= REPLAY_FLAG_FIXED_POINT;
+#endif
+
+	fwrite("BRKR", 1, 4, rec->file);
+	fputc(REPLAY_VERSION, rec->file);
+	fputc(flags, rec->file);
+	WriteU32(rec->file, seed);
+	WriteU32(rec->file, 0); //Ticks and hash are filled in by ReplayEndRecord.
+	WriteU32(rec->file, 0);
+	WriteU32(rec->file, 0);
+	return true;
+}
+
+//******
+//ReplayRecordLevel
+//******
+void ReplayRecordLevel(ReplayRecorder *rec, int level)
+{
+	if (!rec->file) return;
+
+	FlushRun(rec);
+	fputc(REPLAY_LEVEL, rec->file);
+	WriteVarint(rec->file, (unsigned int)level);
+}
+
+//******
+//ReplayRecordTick
+//******
+void ReplayRecordTick(ReplayRecorder *rec, const SimInput *input)
+{
+	if (!rec->file) return;
+
+	const int b = InputToByte(input);
+	if (b != rec->runInput) FlushRun(rec);
+
+	rec->runInput = b;
+	++rec->runLength;
+	++rec->ticks;
+}
+
+//******
+//ReplayEndRecord
+//******
+void ReplayEndRecord(ReplayRecorder *rec, const SimState *s)
+{
+	if (!rec->file) return;
+
+	FlushRun(rec);
+	fputc(REPLAY_END, rec->file);
+
+	const unsigned long long hash = SimHash(s);
+	fseek(rec->file, REPLAY_TICKS_AT, SEEK_SET);
+	WriteU32(rec->file, rec->ticks);
+	WriteU32(rec->file, (unsigned int)hash);
+	WriteU32(rec->file, (unsigned int)(hash >> 32));
+
+	fclose(rec->file);
+	rec->file = NULL;
+}
+
+//******
+//ReplayPlayback
+//******
+bool ReplayPlayback(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	if (!file)
+	{
+		printf("Replay: could not open %s.\n", path);
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	const int size = (int)ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	unsigned char *data = DBG_NEW unsigned char[size > 0 ? size : 1];
+	const bool readAll = (int)fread(data, 1, size, file) == size;
+	fclose(file);
+
+	ReplayReader r = { data, readAll ? size : 0, 0, true };
+
+	if (size < REPLAY_HEADER_SIZE || memcmp(data, "BRKR", 4) != 0)
+	{
+		printf("Replay: %s is not a replay.\n", path);
+		delete[] data;
+		return false;
+	}
+	r.at = 4;
+
+	const int version = ReadByte(&r);
+	const int flags   = ReadByte(&r);
+	const unsigned int seed  = ReadU32(&r);
+	const unsigned int ticks = ReadU32(&r);
+	unsigned long long hash = ReadU32(&r);
+	hash |= (unsigned long long)ReadU32(&r) << 32;
+
+	if (version != REPLAY_VERSION)
+	{
+		printf("Replay: version %d, expected %d.\n", version, REPLAY_VERSION);
+		delete[] data;
+		return false;
+	}
+
+#ifdef SIM_FIXED_POINT
+	const bool sameNumbers = (flags & REPLAY_FLAG_FIXED_POINT) != 0;
+#else
+	const bool sameNumbers = (flags & REPLAY_FLAG_FIXED_POINT) == 0;
+#endif
+	if (!sameNumbers) printf("Replay: recorded with %s simulation, the state hash will not match.\n", flags & REPLAY_FLAG_FIXED_POINT ? "fixed point" : "float");
+
+	SimState *s = DBG_NEW SimState();
+	SimInit(s);
+	SimSeed(s, seed);
+	s->multiBall = (flags & REPLAY_FLAG_MULTIBALL) != 0;
+
+	typedef std::chrono::high_resolution_clock Clock;
+	const Clock::time_point start = Clock::now();
+
+	unsigned int played = 0;
+	int levels = 0;
+	for (;;)
+	{
+		const int op = ReadByte(&r);
+		if (!r.ok || op == REPLAY_END) break;
+
+		if (op == REPLAY_LEVEL)
+		{
+			s->score.level = (int)ReadVarint(&r);
+			SimStartLevel(s);
+			++levels;
+		}
+		else
+		{
+			const SimInput input = ByteToInput(op);
+			const unsigned int run = ReadVarint(&r);
+			for (unsigned int k = 0; k != run; ++k)
+			{
+				SimStep(s, &input, NULL);
+			}
+			played += run;
+		}
+	}
+
+	const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	const bool same = r.ok && played == ticks && SimHash(s) == hash;
+
+	printf("Replay: %s, seed %u, %u ticks, %d levels started.\n", path, seed, played, levels);
+	printf("  %.2f ms, %.0f ticks/sec, %.1fx real time.\n", ms, played / (ms / 1000.0), (played * TIME_STEP) / ms);
+	printf("  %s\n", !r.ok ? "File is truncated." : same ? "Last state matches the recording." : "Last state DIFFERS from the recording.");
+
+	delete s;
+	delete[] data;
+
+	return same;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Simulation.h"
+
+#include <stdio.h>
+
+//******
+//REPLAY
+//Records the input of every SimStep to a file, and plays it back headless.
+//
+//File: header, then a stream of records, all little endian.
+//  header  "BRKR", version, flags, seed (u32), ticks (u32), hash of the last state (u64).
+//  record  input byte + run length (varint)   Same input for run length ticks.
+//          REPLAY_LEVEL + level (varint)       SimStartLevel on that level.
+//          REPLAY_END
+//An input byte is fireBall in bit 0 and moveDir + 1 in bit 1-2.
+//******
+
+#define REPLAY_VERSION 3 //2: block layout from Rng. 3: paddle centered from its start width.
+
+#define REPLAY_FLAG_MULTIBALL   1
+#define REPLAY_FLAG_FIXED_POINT 2
+
+struct ReplayRecorder
+{
+	FILE *file;
+
+	//Current run, written when the input changes.
+	int          runInput;
+	unsigned int runLength;
+
+	unsigned int ticks;
+};
+
+//Open path and write the header. s must be after SimInit, seed is what was passed to SimSeed.
+bool ReplayBeginRecord(ReplayRecorder *rec, const char *path, const SimState *s, unsigned int seed);
+
+//Call right before SimStartLevel, with score.level already set.
+void ReplayRecordLevel(ReplayRecorder *rec, int level);
+
+//Call right before SimStep with the same input.
+void ReplayRecordTick(ReplayRecorder *rec, const SimInput *input);
+
+//Finish the file, s is stored as a hash so playback can verify it ended in the same state.
+void ReplayEndRecord(ReplayRecorder *rec, const SimState *s);
+
+//Re-simulate a recording as fast as possible and print timing.
+//Returns false if the file is broken or the last state does not match the recording.
+bool ReplayPlayback(const char *path);
@@ -0,0 +1,631 @@
+#include "Simulation.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "Collision.h"
+
+#define MIN(X, Y) ((X) < (Y) ? (X) : (Y))
+#define MAX(X, Y) ((X) > (Y) ? (X) : (Y))
+
+#define MAX_BALL_CANDIDATES 64
+
+//A ball can bounce this many times in one tick, whatever is left of the move after that is dropped.
+#define MAX_SWEEP_ITERATIONS 8
+
+//******
+//SimInit
+//******
+void SimInit(SimState *s)
+{
+	BlockStoreClear(&s->blocks);
+
+	//paddle
+	s->paddle.maxWidth = PADDLE_FRAME_SIZE * 13;
+	s->paddle.maxVel = 10.0f;
+
+	//Ball
+	s->balls.maxVel = RealVec2(1.0f, 5.0f);
+	s->balls.count  = 0;
+	s->multiBall    = false;
+
+	//Blocks
+	s->blockMaxColumns = WINDOW_WIDTH % BLOCK_WIDTH;
+	s->blockMaxRows    = 4;
+
+	s->blockOffsetX = 10;
+	s->blockOffsetY = 3;
+
+	//Level
+	s->score.level = 1;
+
+	SimSeed(s, 1);
+}
+
+//******
+//SimSeed
+//******
+void SimSeed(SimState *s, unsigned int seed)
+{
+	RngSeed(&s->rng, seed, RNG_STREAM_BLOCKS);
+}
+
+//******
+//SimStartLevel
+//******
+void SimStartLevel(SimState *s)
+{
+	//Score
+	s->score.accumulator = 0.0f;
+	s->score.points      = 0;
+
+	//paddle
+	Paddle *paddle = &s->paddle;
+	paddle->size  = RealVec2(PADDLE_START_WIDTH, PADDLE_START_HEIGHT);
+	paddle->pos   = RealVec2((WINDOW_WIDTH / 2) - (paddle->size.x / 2), WINDOW_HEIGHT - PADDLE_FRAME_SIZE);
+	paddle->vel   = 0.0f;
+	paddle->dir   = 0;
+	paddle->angle = 0.0f;
+
+	//Ball, waiting on the paddle.
+	BallStore *balls = &s->balls;
+	balls->count   = 1;
+	balls->velX[0] = 0.0f;
+	balls->velY[0] = 0.0f;
+
+	//Level
+	s->timeSinceABlockWasHited = 0.0f;
+
+	//Blocks
+	const int length    = s->blockMaxColumns * s->blockMaxRows - s->blockOffsetX;
+	const int numBlocks = length - (length % s->blockMaxRows);
+
+	BlockStore *blocks = &s->blocks;
+	BlockStoreClear(blocks);
+
+	int x = s->blockOffsetX;
+	int y = s->blockOffsetY;
+	for (int i = 0; i != numBlocks; ++i)
+	{
+		//Block position
+		if (x == s->blockMaxColumns)
+		{
+			++y;
+			x = s->blockOffsetX;
+		}
+		BlockStoreAdd(blocks, x++ * BLOCK_WIDTH, y * BLOCK_HEIGHT, RngInt(&s->rng, BLOCK_TYPES), 2);
+	}
+}
+
+//******
+//LowerBlocks
+//Returns false if the blocks has reached the paddle.
+//******
+static bool LowerBlocks(SimState *s)
+{
+	BlockStore *blocks = &s->blocks;
+
+	Real lowestY;
+	if (BlockStoreLowestRow(blocks, &lowestY) && lowestY > s->paddle.pos.y - (s->paddle.size.y * 6))
+	{
+		return false;
+	}
+
+	BlockStoreLower(blocks, 10);
+	return true;
+}
+
+//******
+//SimSpawnBall
+//******
+bool SimSpawnBall(SimState *s, const RealVec2 &pos, const RealVec2 &vel)
+{
+	BallStore *balls = &s->balls;
+	if (balls->count == MAX_BALLS) return false;
+
+	const int i = balls->count++;
+	balls->posX[i] = pos.x;
+	balls->posY[i] = pos.y;
+	balls->velX[i] = vel.x;
+	balls->velY[i] = vel.y;
+	return true;
+}
+
+enum ContactType
+{
+	CONTACT_NONE = 0,
+	CONTACT_BLOCK,
+	CONTACT_PADDLE,
+	CONTACT_WALL,
+};
+
+struct Contact
+{
+	int   type;
+	int   block;
+	Real time;   //Fraction of the move.
+	RealVec2  normal; //Face that was hit.
+};
+
+//******
+//FindFirstContact
+//Earliest block, paddle or wall a ball at pos touches while moving by move.
+//******
+static Contact FindFirstContact(const SimState *s, const RealVec2 &pos, const RealVec2 &move)
+{
+	const Paddle *paddle = &s->paddle;
+
+	Contact first;
+	first.type  = CONTACT_NONE;
+	first.block = -1;
+	first.time  = 1.0f;
+
+	const SweptBox ballBox = { pos, RealVec2(BALL_WIDTH, BALL_HEIGHT) };
+
+	//Blocks, candidates come in ascending order so the lowest index wins a tie.
+	const RealVec2 to = pos + move;
+	int candidates[MAX_BALL_CANDIDATES];
+	const int numCandidates = BlockStoreQuery(&s->blocks,
+		MIN(pos.x, to.x), MIN(pos.y, to.y),
+		MAX(pos.x, to.x) + BALL_WIDTH, MAX(pos.y, to.y) + BALL_HEIGHT,
+		candidates, MAX_BALL_CANDIDATES);
+
+	for (int n = 0; n != numCandidates; ++n)
+	{
+		const int i = candidates[n];
+		const SweptBox blockBox = { RealVec2(s->blocks.posX[i], BlockY(&s->blocks, i)), RealVec2(BLOCK_WIDTH, BLOCK_HEIGHT) };
+
+		const SweepResult r = SweptCollision(ballBox, move, blockBox);
+		if (r.hit && r.time < first.time)
+		{
+			first.type   = CONTACT_BLOCK;
+			first.block  = i;
+			first.time   = r.time;
+			first.normal = r.normal;
+		}
+	}
+
+	//Paddle, only on the way down.
+	if (move.y > 0)
+	{
+		const SweptBox paddleBox = { paddle->pos, paddle->size };
+
+		const SweepResult r = SweptCollision(ballBox, move, paddleBox);
+		if (r.hit && r.time < first.time)
+		{
+			first.type   = CONTACT_PADDLE;
+			first.time   = r.time;
+			first.normal = r.normal;
+		}
+	}
+
+	//Window: top, left and right. Bottom is game over.
+	if (move.y < 0 && to.y < 0)
+	{
+		const Real t = MAX(pos.y / -move.y, 0.0f);
+		if (t < first.time)
+		{
+			first.type   = CONTACT_WALL;
+			first.time   = t;
+			first.normal = RealVec2(0.0f, 1.0f);
+		}
+	}
+	if (move.x < 0 && to.x < 0)
+	{
+		const Real t = MAX(pos.x / -move.x, 0.0f);
+		if (t < first.time)
+		{
+			first.type   = CONTACT_WALL;
+			first.time   = t;
+			first.normal = RealVec2(1.0f, 0.0f);
+		}
+	}
+	else if (move.x > 0 && to.x + BALL_WIDTH > WINDOW_WIDTH)
+	{
+		const Real t = MAX((WINDOW_WIDTH - BALL_WIDTH - pos.x) / move.x, 0.0f);
+		if (t < first.time)
+		{
+			first.type   = CONTACT_WALL;
+			first.time   = t;
+			first.normal = RealVec2(-1.0f, 0.0f);
+		}
+	}
+
+	return first;
+}
+
+//******
+//HitBlock
+//******
+static int HitBlock(SimState *s, int i, const RealVec2 &normal, RealVec2 *vel, SimHits *hits)
+{
+	int events = SIM_EVENT_NONE;
+
+	Paddle     *paddle = &s->paddle;
+	Score      *score  = &s->score;
+	BlockStore *blocks = &s->blocks;
+
+	const RealVec2 maxVel = s->balls.maxVel;
+
+	//Bounce
+	if (normal.y > 0)      vel->y = maxVel.y;  //Bottom of block.
+	else if (normal.y < 0) vel->y = -maxVel.y; //Up side of block.
+	else if (normal.x < 0) vel->x = -maxVel.x; //Left side of block.
+	else                   vel->x = maxVel.x;  //Right side of block.
+
+	//Eval result
+	const int health = blocks->health[i] == 1 ? 0 : 1;
+
+	if (hits && hits->count != MAX_SIM_HITS)
+	{
+		hits->block[hits->count]  = i;
+		hits->health[hits->count] = health;
+		++hits->count;
+	}
+
+	//If player ended block lifetime. Deactivate block and extend paddle length.
+	if (health == 0)
+	{
+		BlockStoreKill(blocks, i);
+
+		//Extend length.
+		if (paddle->size.x <= paddle->maxWidth)
+		{
+			paddle->size.x += PADDLE_FRAME_SIZE;
+			paddle->pos.x  -= PADDLE_FRAME_SIZE / 2;
+		}
+
+		//Increase score.
+		score->points += 1;
+
+		//Goto next level.
+		if (blocks->liveCount == 0)
+		{
+			events |= score->level == 3 ? SIM_EVENT_GAME_COMPLETED : SIM_EVENT_LEVEL_COMPLETED;
+		}
+
+		//Lower block y speed.
+		if (score->level == 3)
+		{
+			s->timeSinceABlockWasHited = 0.0f;
+		}
+
+		//Multi-ball: release a new ball from the block, falling.
+		if (s->multiBall)
+		{
+			const RealVec2 spawnPos = RealVec2(blocks->posX[i] + (BLOCK_WIDTH / 2 - BALL_WIDTH / 2), BlockY(blocks, i) + BLOCK_HEIGHT);
+			SimSpawnBall(s, spawnPos, RealVec2(i & 1 ? maxVel.x : -maxVel.x, maxVel.y));
+		}
+
+		events |= SIM_EVENT_BLOCK_DESTROYED;
+	}
+	else
+	{
+		blocks->health[i] = (unsigned char)health;
+
+		events |= SIM_EVENT_BLOCK_HIT;
+	}
+
+	//Check if block is of type 1, in that case apply extra energy to ball.
+	if (blocks->type[i] == 0)
+	{
+		vel->x > 0 ? vel->x *= 2 : vel->y *= 2;
+	}
+
+	return events;
+}
+
+//******
+//ResolveContact
+//Ball at pos is touching what contact describes, bounce it. Returns a mask of SimEvent.
+//******
+static int ResolveContact(SimState *s, const Contact *contact, const RealVec2 &pos, RealVec2 *vel, SimHits *hits)
+{
+	Paddle *paddle = &s->paddle;
+
+	const RealVec2 maxVel = s->balls.maxVel;
+
+	if (contact->type == CONTACT_BLOCK)
+	{
+		return HitBlock(s, contact->block, contact->normal, vel, hits);
+	}
+	else if (contact->type == CONTACT_PADDLE)
+	{
+		//Percentage.
+		const Real w = paddle->pos.x + paddle->size.x - (pos.x + (BALL_WIDTH / 2));
+		paddle->angle = (w / paddle->size.x - 0.5f); // 0.5 -> -0.5
+
+		if (paddle->angle < 0.1f && paddle->angle > -0.1f) paddle->angle = 0.0f; //Middle
+		else paddle->angle > 0.1f ? paddle->angle -= 1.0 : paddle->angle += 1.0f; //Left or Right.
+
+		vel->x = maxVel.x * paddle->angle;
+		vel->y = -maxVel.y;
+
+		return SIM_EVENT_PADDLE_HIT;
+	}
+	else if (contact->type == CONTACT_WALL)
+	{
+		//Top
+		if (contact->normal.y > 0)
+		{
+			vel->y = maxVel.y;
+		}
+		//Right
+		else if (contact->normal.x < 0)
+		{
+			vel->x = -RealAbs(maxVel.x * paddle->angle);
+		}
+		//Left
+		else
+		{
+			vel->x = RealAbs(maxVel.x * paddle->angle);
+		}
+	}
+
+	return SIM_EVENT_NONE;
+}
+
+//******
+//SweepBall
+//Move ball i, stop at every contact on the way and bounce from there.
+//******
+static int SweepBall(SimState *s, int i, SimHits *hits)
+{
+	BallStore *balls = &s->balls;
+
+	int events = SIM_EVENT_NONE;
+
+	RealVec2 pos = RealVec2(balls->posX[i], balls->posY[i]);
+	RealVec2 vel = RealVec2(balls->velX[i], balls->velY[i]);
+
+	Real remaining = 1.0f;
+	for (int k = 0; k != MAX_SWEEP_ITERATIONS && remaining > 0.0f; ++k)
+	{
+		const RealVec2 move = vel * remaining;
+		const Contact contact = FindFirstContact(s, pos, move);
+
+		pos += move * contact.time;
+		remaining -= remaining * contact.time;
+
+		if (contact.type == CONTACT_NONE) break;
+
+		events |= ResolveContact(s, &contact, pos, &vel, hits);
+	}
+
+	balls->posX[i] = pos.x;
+	balls->posY[i] = pos.y;
+	balls->velX[i] = vel.x;
+	balls->velY[i] = vel.y;
+
+	return events;
+}
+
+//******
+//StepBalls
+//One pass over every ball in flight. Balls whose swept box is clear of walls,
+//paddle and block cells just move, the rest go through SweepBall in index order.
+//******
+static int StepBalls(SimState *s, SimHits *hits)
+{
+	BallStore *balls  = &s->balls;
+	Paddle    *paddle = &s->paddle;
+
+	int events = SIM_EVENT_NONE;
+
+	//On the stack so SimStep stays reentrant, SimState is snapshotted as a whole.
+	int narrow[MAX_BALLS];
+	int numNarrow = 0;
+
+	const int count = balls->count;
+	for (int i = 0; i != count; ++i)
+	{
+		const Real x0 = balls->posX[i];
+		const Real y0 = balls->posY[i];
+		const Real x1 = x0 + balls->velX[i];
+		const Real y1 = y0 + balls->velY[i];
+
+		const Real minX = MIN(x0, x1);
+		const Real minY = MIN(y0, y1);
+		const Real maxX = MAX(x0, x1) + BALL_WIDTH;
+		const Real maxY = MAX(y0, y1) + BALL_HEIGHT;
+
+		const bool inWindow  = minX >= 0 && minY >= 0 && maxX <= WINDOW_WIDTH;
+		const bool offPaddle = maxY <= paddle->pos.y || maxX <= paddle->pos.x || minX >= paddle->pos.x + paddle->size.x;
+
+		int candidate;
+		if (inWindow && offPaddle && BlockStoreQuery(&s->blocks, minX, minY, maxX, maxY, &candidate, 1) == 0)
+		{
+			balls->posX[i] = x1;
+			balls->posY[i] = y1;
+		}
+		else
+		{
+			narrow[numNarrow++] = i;
+		}
+	}
+
+	for (int n = 0; n != numNarrow; ++n)
+	{
+		events |= SweepBall(s, narrow[n], hits);
+	}
+
+	//Collisiondetection: Ball vs window bottom.
+	//A lost ball is removed, losing the last one is game over.
+	for (int i = 0; i < balls->count; )
+	{
+		if (balls->posY[i] + BALL_HEIGHT > WINDOW_HEIGHT)
+		{
+			if (balls->count == 1)
+			{
+				events |= SIM_EVENT_GAME_OVER;
+				break;
+			}
+
+			const int last = --balls->count;
+			balls->posX[i] = balls->posX[last];
+			balls->posY[i] = balls->posY[last];
+			balls->velX[i] = balls->velX[last];
+			balls->velY[i] = balls->velY[last];
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	return events;
+}
+
+//*****
+//SimStep
+//*****
+int SimStep(SimState *s, const SimInput *input, SimHits *hits)
+{
+	const Real delta = TIME_STEP;
+
+	int events = SIM_EVENT_NONE;
+
+	Paddle    *paddle = &s->paddle;
+	BallStore *balls  = &s->balls;
+	Score     *score  = &s->score;
+
+	if (hits) hits->count = 0;
+
+	if (input->fireBall)
+	{
+		balls->velX[0] = 0.0f;
+		balls->velY[0] = -balls->maxVel.y;
+	}
+
+	//paddle: Movement.
+	if (input->moveDir != 0)
+	{
+		paddle->dir = input->moveDir;
+		if (paddle->vel < paddle->maxVel) paddle->vel += 0.7f;
+	}
+	else
+	{
+		(paddle->vel > 0) ? paddle->vel -= 0.9f : paddle->vel = 0.0f;
+	}
+
+	//Collisiondetection Paddle vs Window.
+	if (paddle->pos.x < 0)
+	{
+		paddle->pos.x = 0;
+		paddle->vel   = 0;
+	}
+	else if (paddle->pos.x + paddle->size.x > WINDOW_WIDTH)
+	{
+		paddle->pos.x = WINDOW_WIDTH - paddle->size.x;
+		paddle->vel   = 0;
+	}
+	else
+	{
+		paddle->pos.x += paddle->vel * paddle->dir; //No collision, update movement.
+	}
+
+	//Ball: Movement.
+	//Paddle has not fired ball.
+	if (balls->count == 1 && balls->velX[0] == 0 && balls->velY[0] == 0)
+	{
+		balls->posX[0] = paddle->pos.x + (paddle->size.x / 2 - (BALL_WIDTH / 2));
+		balls->posY[0] = paddle->pos.y - BALL_HEIGHT;
+	}
+	else
+	{
+		events |= StepBalls(s, hits);
+	}
+
+	//Level
+	//Level: 1
+	//Do nothing special.
+	if (score->level == 1)
+	{
+
+	}
+	//Level: 2
+	else if (score->level == 2)
+	{
+		//Lower blocks (constant speed).
+		score->accumulator += delta;
+		if (score->accumulator > TIME_BETWEEN_LOWERING_BLOCKS)
+		{
+			score->accumulator = 0.0f;
+
+			if (!LowerBlocks(s)) events |= SIM_EVENT_GAME_OVER;
+		}
+	}
+	//Level: 3
+	else if (score->level == 3)
+	{
+		//Lower blocks (increase speed if failing to kill any block).
+		score->accumulator += delta;
+		if (score->accumulator > TIME_BETWEEN_LOWERING_BLOCKS)
+		{
+			score->accumulator = 0.0f;
+
+			if (!LowerBlocks(s)) events |= SIM_EVENT_GAME_OVER;
+		}
+
+		//Increase speed.
+		s->timeSinceABlockWasHited += delta;
+		if (s->timeSinceABlockWasHited > (TIME_BETWEEN_LOWERING_BLOCKS * 2))
+		{
+			score->accumulator += delta;
+		}
+	}
+
+	return events;
+}
+
+//******
+//SimHash
+//******
+static inline void HashBits(unsigned long long *h, unsigned bits)
+{
+	*h = (*h ^ bits) * 1099511628211ULL;
+}
+
+unsigned long long SimHash(const SimState *s)
+{
+	unsigned long long h = 14695981039346656037ULL;
+
+	const Paddle *paddle = &s->paddle;
+	HashBits(&h, RealBits(paddle->pos.x));
+	HashBits(&h, RealBits(paddle->pos.y));
+	HashBits(&h, RealBits(paddle->size.x));
+	HashBits(&h, RealBits(paddle->vel));
+	HashBits(&h, RealBits(paddle->angle));
+	HashBits(&h, (unsigned)paddle->dir);
+
+	const BallStore *balls = &s->balls;
+	HashBits(&h, (unsigned)balls->count);
+	for (int i = 0; i != balls->count; ++i)
+	{
+		HashBits(&h, RealBits(balls->posX[i]));
+		HashBits(&h, RealBits(balls->posY[i]));
+		HashBits(&h, RealBits(balls->velX[i]));
+		HashBits(&h, RealBits(balls->velY[i]));
+	}
+
+	//Dead blocks never change again, the live list and offset cover the rest.
+	const BlockStore *blocks = &s->blocks;
+	HashBits(&h, RealBits(blocks->offsetY));
+	HashBits(&h, (unsigned)blocks->liveCount);
+	for (int n = 0; n != blocks->liveCount; ++n)
+	{
+		const int i = blocks->live[n];
+		HashBits(&h, (unsigned)i);
+		HashBits(&h, blocks->health[i]);
+	}
+
+	const Score *score = &s->score;
+	HashBits(&h, (unsigned)score->level);
+	HashBits(&h, (unsigned)score->points);
+	HashBits(&h, RealBits(score->accumulator));
+	HashBits(&h, RealBits(s->timeSinceABlockWasHited));
+	HashBits(&h, (unsigned)s->rng.state);
+	HashBits(&h, (unsigned)(s->rng.state >> 32));
+
+	return h;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "Real.h"
+#include "Blocks.h"
+#include "Random.h"
+
+//******
+//SIMULATION
+//Everything needed to play the game, no SDL in here.
+//Rendering, sound and menus live in main.cpp and react on the events returned by SimStep.
+//State is kept in Real, see Real.h for the fixed point build.
+//******
+
+#define TIME_STEP  ((1.0f / 60.0f) * 1000.f) // 60 fps.
+
+#define WINDOW_HEIGHT 720
+#define WINDOW_WIDTH  1080
+
+//paddle
+struct Paddle
+{
+#define PADDLE_FRAME_SIZE 16
+#define PADDLE_START_WIDTH PADDLE_FRAME_SIZE * 3
+#define PADDLE_START_HEIGHT PADDLE_FRAME_SIZE
+
+	RealVec2 pos;
+	RealVec2 size;
+	Real     maxWidth;
+
+	Real vel;
+	Real maxVel;
+	Real angle;
+	int  dir;
+};
+
+//Balls, structure of arrays.
+//Ball 0 is the one the paddle fires, the rest only exist in multi-ball mode.
+struct BallStore
+{
+#define BALL_WIDTH  8
+#define BALL_HEIGHT 8
+
+#define BALL_FRAME_X 0
+#define BALL_FRAME_Y 48
+
+#define MAX_BALLS 4096
+
+	Real posX[MAX_BALLS];
+	Real posY[MAX_BALLS];
+	Real velX[MAX_BALLS];
+	Real velY[MAX_BALLS];
+	int  count;
+
+	RealVec2 maxVel;
+};
+
+//Score
+struct Score
+{
+	int level;
+	int points;
+
+	Real accumulator;
+};
+
+#define TIME_BETWEEN_LOWERING_BLOCKS 2000
+
+//Input for one tick.
+struct SimInput
+{
+	int  moveDir;  //-1 left, 1 right, 0 no arrow is held.
+	bool fireBall; //Arrow 'UP' was pressed.
+};
+
+//What happened during one tick, returned by SimStep.
+enum SimEvent
+{
+	SIM_EVENT_NONE            = 0,
+	SIM_EVENT_BLOCK_HIT       = 1 << 0, //Block was damaged but is still alive.
+	SIM_EVENT_BLOCK_DESTROYED = 1 << 1,
+	SIM_EVENT_PADDLE_HIT      = 1 << 2,
+	SIM_EVENT_GAME_OVER       = 1 << 3,
+	SIM_EVENT_LEVEL_COMPLETED = 1 << 4,
+	SIM_EVENT_GAME_COMPLETED  = 1 << 5,
+};
+
+//Blocks hit during one tick, filled by SimStep.
+struct SimHits
+{
+#define MAX_SIM_HITS 64
+	int block[MAX_SIM_HITS];
+	int health[MAX_SIM_HITS]; //Health left after the hit, 0 if destroyed.
+	int count;
+};
+
+struct SimState
+{
+	Paddle    paddle;
+	BallStore balls;
+
+	//Every destroyed block releases a new ball, and the game is only over when the last ball is lost.
+	bool multiBall;
+
+	BlockStore blocks;
+	int blockMaxColumns;
+	int blockMaxRows;
+	int blockOffsetX;
+	int blockOffsetY;
+
+	Score score;
+	Real  timeSinceABlockWasHited;
+
+	//Block layout, RNG_STREAM_BLOCKS.
+	Rng rng;
+};
+
+//Set up constants, call once.
+void SimInit(SimState *s);
+
+//Seed the random numbers used by SimStartLevel.
+void SimSeed(SimState *s, unsigned int seed);
+
+//Build the blocks for score.level and reset paddle, ball and points.
+void SimStartLevel(SimState *s);
+
+//Add a ball in flight, returns false if there is no room.
+bool SimSpawnBall(SimState *s, const RealVec2 &pos, const RealVec2 &vel);
+
+//Advance the game one TIME_STEP, returns a mask of SimEvent.
+//hits is optional.
+int SimStep(SimState *s, const SimInput *input, SimHits *hits);
+
+//FNV-1a over ball, paddle, block and score state.
+//Two runs fed the same input give the same hash, in the fixed point build also across compilers.
+unsigned long long SimHash(const SimState *s);
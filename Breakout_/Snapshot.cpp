@@ -0,0 +1,211 @@
+#include "Snapshot.h"
+
+#include <cassert>
+#include <string.h>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<SimState>::value, "SimState is copied with memcpy, keep it plain data.");
+static_assert(sizeof(SimState) % 4 == 0, "SimState is diffed as words.");
+static_assert(SNAPSHOT_WORDS < 0x10000, "Run offsets are 16 bit.");
+
+//******
+//Word access
+//******
+static inline unsigned int LoadWord(const unsigned char *p)
+{
+	unsigned int w;
+	memcpy(&w, p, 4);
+	return w;
+}
+
+static inline void StoreWord(unsigned char *p, unsigned int w)
+{
+	memcpy(p, &w, 4);
+}
+
+static inline void StoreU16(unsigned char *p, int val)
+{
+	p[0] = (unsigned char)val;
+	p[1] = (unsigned char)(val >> 8);
+}
+
+static inline int LoadU16(const unsigned char *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+//******
+//EncodeDelta
+//xor of a and b as runs: skip (u16 words), length (u16 words), length xor words.
+//A single unchanged word inside a run is kept, it is cheaper than a new run header.
+//Returns number of bytes written to out.
+//******
+static int EncodeDelta(const SimState *a, const SimState *b, unsigned char *out)
+{
+	const unsigned int *wa = (const unsigned int *)a;
+	const unsigned int *wb = (const unsigned int *)b;
+	const int words = (int)(sizeof(SimState) / 4);
+
+	int size = 0;
+	int last = 0; //End of previous run.
+	int i = 0;
+	while (i < words)
+	{
+		if (wa[i] == wb[i])
+		{
+			++i;
+			continue;
+		}
+
+		//Run starts at i, extend it over changed words and one word gaps.
+		const int start = i;
+		int end = i + 1;
+		while (end < words)
+		{
+			if (wa[end] != wb[end]) ++end;
+			else if (end + 1 < words && wa[end + 1] != wb[end + 1]) end += 2;
+			else break;
+		}
+
+		StoreU16(out + size, start - last);
+		StoreU16(out + size + 2, end - start);
+		size += 4;
+		for (int k = start; k != end; ++k)
+		{
+			StoreWord(out + size, wa[k] ^ wb[k]);
+			size += 4;
+		}
+
+		last = end;
+		i = end;
+	}
+
+	return size;
+}
+
+//******
+//ApplyDelta
+//******
+static void ApplyDelta(SimState *s, const unsigned char *delta, int size)
+{
+	unsigned char *bytes = (unsigned char *)s;
+
+	int at = 0;
+	int word = 0;
+	while (at < size)
+	{
+		word += LoadU16(delta + at);
+		const int length = LoadU16(delta + at + 2);
+		at += 4;
+
+		for (int k = 0; k != length; ++k)
+		{
+			unsigned char *p = bytes + (word + k) * 4;
+			StoreWord(p, LoadWord(p) ^ LoadWord(delta + at));
+			at += 4;
+		}
+		word += length;
+	}
+}
+
+//******
+//SnapshotClear
+//******
+void SnapshotClear(SnapshotRing *ring)
+{
+	ring->hasHead   = false;
+	ring->first     = 0;
+	ring->count     = 0;
+	ring->poolWrite = 0;
+}
+
+//******
+//DropOldest
+//******
+static void DropOldest(SnapshotRing *ring)
+{
+	ring->first = (ring->first + 1) % SNAPSHOT_CAPACITY;
+	--ring->count;
+}
+
+//******
+//SnapshotPush
+//******
+void SnapshotPush(SnapshotRing *ring, const SimState *s)
+{
+	if (!ring->hasHead)
+	{
+		memcpy(&ring->head, s, sizeof(SimState));
+		ring->hasHead = true;
+		return;
+	}
+
+	//Delta turns the new head back into the old one.
+	const int size = EncodeDelta(&ring->head, s, ring->scratch);
+	assert(size <= SNAPSHOT_POOL_SIZE);
+
+	if (ring->count == SNAPSHOT_CAPACITY) DropOldest(ring);
+
+	//A delta is never split, skip the end of the pool if it does not fit.
+	const int at = (int)(ring->poolWrite % SNAPSHOT_POOL_SIZE);
+	if (at + size > SNAPSHOT_POOL_SIZE) ring->poolWrite += SNAPSHOT_POOL_SIZE - at;
+
+	//Everything that started more than a pool size before the end of this delta gets written over.
+	const long long begin = ring->poolWrite;
+	const long long end   = begin + size;
+	while (ring->count > 0 && ring->deltaStart[ring->first] < end - SNAPSHOT_POOL_SIZE)
+	{
+		DropOldest(ring);
+	}
+
+	memcpy(ring->pool + begin % SNAPSHOT_POOL_SIZE, ring->scratch, size);
+	ring->poolWrite = end;
+
+	const int n = (ring->first + ring->count) % SNAPSHOT_CAPACITY;
+	ring->deltaStart[n] = begin;
+	ring->deltaSize[n]  = size;
+	++ring->count;
+
+	memcpy(&ring->head, s, sizeof(SimState));
+}
+
+//******
+//SnapshotCount
+//******
+int SnapshotCount(const SnapshotRing *ring)
+{
+	return ring->hasHead ? ring->count : 0;
+}
+
+//******
+//SnapshotRestore
+//******
+bool SnapshotRestore(const SnapshotRing *ring, int ticksBack, SimState *out)
+{
+	if (!ring->hasHead || ticksBack < 0 || ticksBack > ring->count) return false;
+
+	memcpy(out, &ring->head, sizeof(SimState));
+	for (int k = 0; k != ticksBack; ++k)
+	{
+		const int n = (ring->first + ring->count - 1 - k) % SNAPSHOT_CAPACITY;
+		ApplyDelta(out, ring->pool + ring->deltaStart[n] % SNAPSHOT_POOL_SIZE, ring->deltaSize[n]);
+	}
+	return true;
+}
+
+//******
+//SnapshotRewind
+//******
+bool SnapshotRewind(SnapshotRing *ring, int ticksBack, SimState *out)
+{
+	if (!SnapshotRestore(ring, ticksBack, out)) return false;
+	if (ticksBack == 0) return true;
+
+	ring->count -= ticksBack;
+
+	//Newer deltas are gone, write over them.
+	ring->poolWrite = ring->deltaStart[(ring->first + ring->count) % SNAPSHOT_CAPACITY];
+
+	memcpy(&ring->head, out, sizeof(SimState));
+	return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Simulation.h"
+
+//******
+//SNAPSHOT
+//Ring of the last SNAPSHOT_CAPACITY ticks of SimState, for rewind.
+//Only the newest state is kept whole. Every older tick is stored as the xor between it and the tick after,
+//packed as runs of changed words, so a tick where the ball and paddle moved costs a few dozen bytes.
+//Restoring k ticks back is one copy and k small xors, nothing is allocated.
+//******
+
+struct SnapshotRing
+{
+#define SNAPSHOT_CAPACITY  (60 * 10)          //Ticks, 10 seconds.
+#define SNAPSHOT_POOL_SIZE (4 * 1024 * 1024)  //Bytes for the deltas, oldest are dropped when it is full.
+#define SNAPSHOT_WORDS     ((sizeof(SimState) + 3) / 4)
+
+	//Newest state.
+	SimState head;
+	bool     hasHead;
+
+	//Delta of entry n turns the state after it back into the state of that tick.
+	//Circular, oldest at first.
+	long long deltaStart[SNAPSHOT_CAPACITY]; //Byte position counted from the first push, pool index is start % SNAPSHOT_POOL_SIZE.
+	int       deltaSize[SNAPSHOT_CAPACITY];
+	int       first;
+	int       count;
+
+	unsigned char pool[SNAPSHOT_POOL_SIZE];
+	long long     poolWrite;
+
+	//Delta is packed here before it is copied to the pool.
+	unsigned char scratch[SNAPSHOT_WORDS * 4 + SNAPSHOT_WORDS * 2 + 4];
+};
+
+void SnapshotClear(SnapshotRing *ring);
+
+//Store s as the newest tick.
+void SnapshotPush(SnapshotRing *ring, const SimState *s);
+
+//Number of ticks it is possible to go back.
+int SnapshotCount(const SnapshotRing *ring);
+
+//State ticksBack ticks before the newest, 0 is the newest. Returns false if it is too old or the ring is empty.
+bool SnapshotRestore(const SnapshotRing *ring, int ticksBack, SimState *out);
+
+//Same as SnapshotRestore, then drop the newer ticks so pushing continues from there.
+bool SnapshotRewind(SnapshotRing *ring, int ticksBack, SimState *out);
@@ -0,0 +1,82 @@
+#include "SpriteBatch.h"
+
+#include <algorithm>
+#include <cassert>
+
+#define SPRITE_KEY_LAYER_SHIFT   48
+#define SPRITE_KEY_TEXTURE_SHIFT 32
+#define SPRITE_KEY_INDEX_MASK    0xffffffffULL
+
+//******
+//SpriteBatchBeginFrame
+//******
+void SpriteBatchBeginFrame(SpriteBatch *batch)
+{
+	batch->count           = 0;
+	batch->numTextures     = 0;
+	batch->lastTexture     = NULL;
+	batch->drawCalls       = 0;
+	batch->textureSwitches = 0;
+}
+
+//******
+//TextureIndex
+//******
+static int TextureIndex(SpriteBatch *batch, SDL_Texture *texture)
+{
+	for (int i = 0; i != batch->numTextures; ++i)
+	{
+		if (batch->textures[i] == texture) return i;
+	}
+
+	assert(batch->numTextures < MAX_SPRITE_TEXTURES);
+	batch->textures[batch->numTextures] = texture;
+	return batch->numTextures++;
+}
+
+//******
+//SpriteBatchAdd
+//******
+void SpriteBatchAdd(SpriteBatch *batch, SDL_Renderer *renderer, SpriteLayer layer, SDL_Texture *texture, Vec2 position, Vec2 size, Vec2 frame, Vec2 scale)
+{
+	if (!texture) return;
+	if (batch->count == MAX_SPRITES || batch->numTextures == MAX_SPRITE_TEXTURES) SpriteBatchFlush(batch, renderer);
+
+	const int i = batch->count++;
+	batch->texture[i] = texture;
+
+	const SDL_Rect dest = { position.ToIntX(), position.ToIntY(), size.ToIntX() * scale.ToIntX(), size.ToIntY() * scale.ToIntY() };
+	const SDL_Rect src  = { frame.ToIntX(), frame.ToIntY(), size.ToIntX(), size.ToIntY() };
+	batch->dest[i] = dest;
+	batch->src[i]  = src;
+
+	batch->key[i] = ((unsigned long long)layer << SPRITE_KEY_LAYER_SHIFT) |
+		((unsigned long long)TextureIndex(batch, texture) << SPRITE_KEY_TEXTURE_SHIFT) |
+		(unsigned long long)i;
+}
+
+//******
+//SpriteBatchFlush
+//******
+void SpriteBatchFlush(SpriteBatch *batch, SDL_Renderer *renderer)
+{
+	//The index is part of the key, so a plain sort keeps queue order.
+	std::sort(batch->key, batch->key + batch->count);
+
+	for (int n = 0; n != batch->count; ++n)
+	{
+		const int i = (int)(batch->key[n] & SPRITE_KEY_INDEX_MASK);
+
+		if (batch->texture[i] != batch->lastTexture)
+		{
+			++batch->textureSwitches;
+			batch->lastTexture = batch->texture[i];
+		}
+
+		++batch->drawCalls;
+		SDL_RenderCopy(renderer, batch->texture[i], &batch->src[i], &batch->dest[i]);
+	}
+
+	batch->count       = 0;
+	batch->numTextures = 0;
+}
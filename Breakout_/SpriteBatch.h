@@ -0,0 +1,51 @@
+#pragma once
+
+#include <SDL.h>
+
+#include "Vector.h"
+
+//******
+//SPRITE BATCH
+//Sprites for one frame are queued with a layer, sorted on layer then texture and sent with
+//SDL_RenderCopy in that order. Queue order is kept for sprites with the same layer and texture.
+//******
+
+enum SpriteLayer
+{
+	SPRITE_LAYER_BACKGROUND = 0,
+	SPRITE_LAYER_BLOCKS,
+	SPRITE_LAYER_BALLS,
+	SPRITE_LAYER_PADDLE,
+	SPRITE_LAYER_EFFECTS,
+	SPRITE_LAYER_TEXT_SHADOW,
+	SPRITE_LAYER_TEXT,
+};
+
+struct SpriteBatch
+{
+#define MAX_SPRITES 8192
+#define MAX_SPRITE_TEXTURES 64 //Different textures in one flush.
+
+	SDL_Texture *texture[MAX_SPRITES];
+	SDL_Rect     src[MAX_SPRITES];
+	SDL_Rect     dest[MAX_SPRITES];
+	unsigned long long key[MAX_SPRITES]; //Layer, texture, queue index.
+	int count;
+
+	//Textures seen since the last flush, the index is the texture part of the key.
+	SDL_Texture *textures[MAX_SPRITE_TEXTURES];
+	int numTextures;
+
+	//Since SpriteBatchBeginFrame.
+	SDL_Texture *lastTexture;
+	int drawCalls;
+	int textureSwitches;
+};
+
+void SpriteBatchBeginFrame(SpriteBatch *batch);
+
+//Same arguments as SpriteDraw. A full batch is flushed first.
+void SpriteBatchAdd(SpriteBatch *batch, SDL_Renderer *renderer, SpriteLayer layer, SDL_Texture *texture, Vec2 position, Vec2 size, Vec2 frame, Vec2 scale);
+
+//Sort and draw everything queued.
+void SpriteBatchFlush(SpriteBatch *batch, SDL_Renderer *renderer);
@@ -16,19 +16,13 @@ struct Vec2
 		this->y = y;
 	}
 
-	void operator=(const Vec2 &v)
-	{
-		x = v.x;
-		y = v.y;
-	}
-
 	void operator+=(const Vec2 &v)
 	{
 		x += v.x;
 		y += v.y;
 	}
 
-	Vec2 operator+(const Vec2 &v)
+	Vec2 operator+(const Vec2 &v) const
 	{
 		return Vec2(v.x + x, v.y + y);
 	}
@@ -39,13 +33,13 @@ struct Vec2
 		y -= v.y;
 	}
 
-	Vec2 operator-(const Vec2 &v)
+	Vec2 operator-(const Vec2 &v) const
 	{
 		return Vec2(x - v.x, y - v.y);
 	}
 
 	//Scalars
-	Vec2 operator*(float val)
+	Vec2 operator*(float val) const
 	{
 		return Vec2(x * val, y * val);
 	}
@@ -57,7 +51,7 @@ struct Vec2
 		y *= val;
 	}
 
-	Vec2 operator/(float val)
+	Vec2 operator/(float val) const
 	{
 		return Vec2(x * (1.0 / val), y * (1.0f / val));
 	}
@@ -81,13 +75,13 @@ struct Vec2
 	}
 
 	//Magnitude
-	float Length()
+	float Length() const
 	{
 		return sqrtf( sqrtf(x) + sqrtf(y) );
 	}
 
 	//Round and convert to int.
-	int ToIntX()
+	int ToIntX() const
 	{
 		int val;
 		x > 0 ? val = (int)(x + 0.5f) : val = (int)(x - 0.5f);
@@ -95,7 +89,7 @@ struct Vec2
 	}
 
 	//Round and convert to int.
-	int ToIntY()
+	int ToIntY() const
 	{
 		int val;
 		y > 0 ? val = (int)(y + 0.5f) : val = (int)(y - 0.5f);
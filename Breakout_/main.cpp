@@ -6,19 +6,22 @@
 
 #include <time.h>
 #include <cassert>
+#include <string.h>
 
 #include "MemAlloc.h"
 #include "Vector.h"
-
-#define TIME_STEP  ((1.0f / 60.0f) * 1000.f) // 60 fps.
-
-struct Color
-{
-	float r;
-	float g;
-	float b;
-	float a;
-};
+#include "Color.h"
+#include "Simulation.h"
+#include "Effects.h"
+#include "ParticleLayer.h"
+#include "Bench.h"
+#include "Replay.h"
+#include "Snapshot.h"
+#include "Jobs.h"
+#include "SpriteBatch.h"
+#include "BlockLayer.h"
+#include "Frame.h"
+#include "Pacer.h"
 
 //******
 //TIMER START
@@ -129,125 +132,6 @@ struct Menu
 //MENU END
 //******
 
-#define MIN(X, Y) (X < Y) ? X : Y
-#define MAX(X, Y) (X > Y) ? X : Y
-
-#define ABS(X) X > 0 ? X : X *= -1
-
-struct AxisBox
-{
-	Vec2 pos;
-	Vec2 size;
-};
-
-struct CollisionResult
-{
-	bool  intersects;
-	Vec2  normal;
-	float length;
-};
-
-//******
-//CollisionDetection
-//SAT (Separating Axis Theorem)
-//boxA is the one to adjust.
-// Adjustment is done by adding collisionResult.normal * collisionResult.length to the position of boxA.
-//******
-CollisionResult CollisionDetection(const AxisBox &boxA, const AxisBox &boxB)
-{
-	const Vec2 xAxis = { 1, 0 };
-	const Vec2 yAxis = { 0, 1 };
-
-	const Vec2 boxAPoints[] = {
-		{boxA.pos},
-		{boxA.pos.x + boxA.size.x / 2.0f, boxA.pos.y},
-		{boxA.pos.x + boxA.size.x / 2.0f, boxA.pos.y + boxA.size.y / 2.0f },
-		{boxA.pos.x, boxA.pos.y + boxA.size.y / 2.0f }
-	};
-
-	const Vec2 boxBPoints[] = {
-		{ boxA.pos },
-		{ boxA.pos.x + boxA.size.x / 2.0f, boxA.pos.y },
-		{ boxA.pos.x + boxA.size.x / 2.0f, boxA.pos.y + boxA.size.y / 2.0f },
-		{ boxA.pos.x, boxA.pos.y + boxA.size.y / 2.0f }
-	};
-
-	float aMinX, aMaxX, aMinY, aMaxY;
-	float bMinX, bMaxX, bMinY, bMaxY;
-
-	aMinX = aMinY = bMinX = bMinY = FLT_MAX;
-	aMaxX = aMaxY = bMaxX = bMaxY = FLT_MIN;
-
-	for (int i = 0; i != 4; ++i)
-	{
-		float aX = boxAPoints[i].DotProduct(xAxis);
-		float aY = boxAPoints[i].DotProduct(yAxis);
-
-		float bX = boxBPoints[i].DotProduct(xAxis);
-		float bY = boxBPoints[i].DotProduct(yAxis);
-		
-		aMinX = MIN(aX, aMinX);
-		aMaxX = MAX(aX, aMaxX);
-		aMinY = MIN(aY, aMinY);
-		aMaxY = MAX(aY, aMaxY);
-
-		bMinX = MIN(bX, bMinX);
-		bMaxX = MAX(bX, bMaxX);
-		bMinY = MIN(bY, bMinY);
-		bMaxY = MAX(bY, bMaxY);
-	}
-
-	CollisionResult result;
-
-	if (aMaxX < bMinX || aMinX > bMaxX || aMaxY < bMinY || aMinY > bMaxY)
-	{
-		result.intersects = false;
-	}
-	else
-	{
-		result.intersects = true;
-
-		float minXPen, minYPen;
-
-		float x0 = bMaxX - aMinX;
-		float x1 = bMinX - aMaxX;
-		float y0 = bMaxY - aMinY;
-		float y1 = bMinY - aMaxY;
-
-		if (ABS(x0) < ABS(x1))
-		{
-			minXPen = x0;
-		}
-		else
-		{
-			minXPen = x1;
-		}
-
-		if (ABS(y0) < ABS(y1))
-		{
-			minYPen = y0;
-		}
-		else
-		{
-			minYPen = y1;
-		}
-
-		if (ABS(minXPen) < ABS(minYPen))
-		{
-			result.normal = xAxis;
-			result.length = minXPen;
-		}
-		else
-		{
-			result.normal = yAxis;
-			result.length = minYPen;
-		}
-	}
-
-
-	return result;
-}
-
 // ******
 // CreateTextTextureFromFile
 // Render text as ANSI(ascii).
@@ -288,11 +172,35 @@ LoadTextureFromFile(SDL_Renderer *renderer, const char *path)
 	return result;
 }
 
+//******
+//DRAW STATS
+//Render calls sent to SDL, shown in the window title.
+//******
+struct DrawStats
+{
+#define DRAW_STATS_INTERVAL 1000.0f //ms between title updates.
+
+	int   calls;     //This frame.
+	int   lastCalls; //Last finished frame.
+	int   textureSwitches;
+	int   lastTextureSwitches;
+	int   particles; //Last play frame.
+	SDL_Texture *lastTexture;
+	float timeToTitle;
+} drawStats;
+
 //******
 //SpriteDraw
 //******
 int SpriteDraw(SDL_Renderer *renderer, SDL_Texture *texture, Vec2 position, Vec2 size, Vec2 frame, Vec2 scale)
 {
+	++drawStats.calls;
+	if (texture != drawStats.lastTexture)
+	{
+		++drawStats.textureSwitches;
+		drawStats.lastTexture = texture;
+	}
+
 	SDL_Rect destRect = { position.ToIntX(), position.ToIntY(), size.ToIntX() * scale.ToIntX(),  size.ToIntY() * scale.ToIntY() };
 	SDL_Rect srcRect  = { frame.ToIntX(), frame.ToIntY(), size.ToIntX(), size.ToIntY() };
 
@@ -313,6 +221,8 @@ void DrawNotFilledRectangle(SDL_Renderer *renderer, const Color &color, float x,
 		{ x, y }
 	};
 
+	++drawStats.calls;
+
 	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
 	assert(SDL_RenderDrawLines(renderer, points, 5) == 0);
 }
@@ -322,6 +232,8 @@ void DrawNotFilledRectangle(SDL_Renderer *renderer, const Color &color, float x,
 //******
 void DrawFilledRectangle(SDL_Renderer *renderer, const Color &color, float x, float y, float w, float h)
 {
+	++drawStats.calls;
+
 	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
 	
 	const SDL_Rect rect = { x, y, w, h };
@@ -329,10 +241,45 @@ void DrawFilledRectangle(SDL_Renderer *renderer, const Color &color, float x, fl
 }
 
 //******
-//InRange
+//DrawParticles
+//Particles sorted by palette index into one rect array, one SDL_RenderFillRects per color.
 //******
-float InRange(float min, float max) {
-	return min + (max - min) * ((float)(rand() % 10001) / 10000.0f);
+SDL_Rect particleRects[MAX_PARTICLES];
+
+void DrawParticles(SDL_Renderer *renderer, const ParticlePool *pool, const Color *palette, int paletteSize)
+{
+	assert(paletteSize <= 256);
+
+	int start[256 + 1] = {};
+	for (int i = 0; i != pool->count; ++i)
+	{
+		assert(pool->color[i] < paletteSize);
+		++start[pool->color[i] + 1];
+	}
+	for (int c = 0; c != paletteSize; ++c)
+	{
+		start[c + 1] += start[c];
+	}
+
+	int next[256];
+	memcpy(next, start, paletteSize * sizeof(int));
+	for (int i = 0; i != pool->count; ++i)
+	{
+		const SDL_Rect rect = { (int)pool->posX[i], (int)pool->posY[i], (int)PARTICLE_SIZE, (int)PARTICLE_SIZE };
+		particleRects[next[pool->color[i]]++] = rect;
+	}
+
+	for (int c = 0; c != paletteSize; ++c)
+	{
+		const int count = start[c + 1] - start[c];
+		if (count == 0) continue;
+
+		++drawStats.calls;
+
+		SDL_SetRenderDrawColor(renderer, palette[c].r, palette[c].g, palette[c].b, palette[c].a);
+		const int result = SDL_RenderFillRects(renderer, particleRects + start[c], count);
+		assert(result == 0);
+	}
 }
 
 //******
@@ -345,9 +292,6 @@ Mix_Music* LoadSound(char *path)
 	return sound;
 }
 
-#define WINDOW_HEIGHT 720
-#define WINDOW_WIDTH  1080
-
 SDL_Window   *sdlWindow   = NULL;
 SDL_Renderer *sdlRenderer = NULL;
 
@@ -356,6 +300,11 @@ SDL_Renderer *sdlRenderer = NULL;
 //******
 
 bool requestToMovePaddle = false;
+int  paddleDir;
+
+//Hold BACKSPACE to rewind.
+#define REWIND_TICKS_PER_TICK 2
+bool requestRewind = false;
 
 SDL_Texture *spriteSheet;
 
@@ -369,98 +318,79 @@ bool isLeftMouseBtnClicked;
 const Vec2 shadowOffset = Vec2(1.0f, 1.0f);
 #define OFFSET_BORDER_TEXTURES 10
 
-//paddle
-struct paddle
-{
-#define PADDLE_FRAME_SIZE 16
-#define PADDLE_START_WIDTH PADDLE_FRAME_SIZE * 3
-#define PADDLE_START_HEIGHT PADDLE_FRAME_SIZE
+SimState sim;
+SimInput simInput;
+SimHits  simHits;
 
-	Vec2  pos;
-	Vec2  size;
-	float maxWidth;
+ReplayRecorder replayRecorder; //Only writes when started with -record.
 
-	float vel;
-	float maxVel;
-	float angle;
-	int   dir;
+SnapshotRing *snapshots;
 
-}paddle; 
+SpriteBatch *spriteBatch; //Play sprites, sorted on layer and texture.
 
-//Splitter
-struct Splitter
+//******
+//INTERPOLATION
+//Paddle and balls as they were before the last tick. Play is drawn between these and sim,
+//the leftover of the update accumulator says how far.
+//******
+struct PrevTick
 {
-	Vec2 pos;
-	Vec2 size;
-
-	Vec2 acc;
-	Vec2 vel;
-
-	Color color;
+#define INTERPOLATE_MAX_STEP 32.0f //Pixels, a longer move in one tick is a jump and is not smoothed.
 
-#define GRAVITY 9.80
-};
-
-#define BLOCK_TYPES 4
-Color blockSplitterColor[BLOCK_TYPES];
+	float paddleX;
+	float ballX[MAX_BALLS];
+	float ballY[MAX_BALLS];
+	int   ballCount;
+} prevTick;
 
-//Explosion
-struct Explosion
+//******
+//PLAY FRAMES
+//GameRenderer draws play from a FrameState. Normally frames[0] is built right before it is drawn.
+//With -pipeline the simulation thread runs the ticks of a pass and builds the back frame while
+//the front frame from the pass before is drawn, then they swap.
+//******
+enum FrameTexture
 {
-#define EXPLOSION_WIDTH  128.0f
-#define EXPLOSION_HEIGHT 128.0f
-#define EXPLOSION_MAX_FRAME_X 3
-#define EXPLOSION_MAX_FRAME_Y 5
-
-	Vec2 pos;
-
-	Vec2 frame;
-	float timeToNextFrame;
-#define EXPLOSION_TIME_BETWEEN_FRAMES TIME_STEP * 3 //Change frame 20 times per second.
+	FRAME_TEXTURE_BACKGROUND = 0,
+	FRAME_TEXTURE_SPRITE_SHEET,
+	FRAME_TEXTURE_BLOCK_LAYER,
+	FRAME_TEXTURE_EXPLOSION,
+	FRAME_TEXTURES,
 };
-SDL_Texture *textureExplosion;
 
-//Block
-struct Block
-{
-#define BLOCK_WIDTH  32
-#define BLOCK_HEIGHT 16
-
-	Vec2 pos;
-
-	int health;
-	int type;
+FrameState *frames[2];
+FrameState *tickFrame; //Block hits of the running ticks are marked here.
 
-#define MAX_NUMBER_OF_SPLITTER 12
-	Splitter blockSplitter[MAX_NUMBER_OF_SPLITTER];
-	bool isSplitterActive;
+bool usePipeline = false;
+int  frontFrame  = 0;
+bool frontFrameReady = false; //Built by the pass before and not drawn yet.
 
-	Explosion explosion;
-	bool isExplosinActive;
-
-} *blocks;
+//Work for the simulation thread, one pass.
+struct SimJob
+{
+	FrameState *frame; //Back frame to build.
+	int      ticks;
+	SimInput input;    //fireBall is only given to the first tick.
+	bool     rewind;
+	float    alpha;
+	int      events;   //SimEvent mask of every tick, set by the thread.
+} simJob;
 
-int blockMaxColumns;
-int blockMaxRows;
-int blockOffsetX;
-int blockOffsetY;
-int numberOfBlocks;
+JobThread simThread;
 
-int numberOfActiveBLocks;
+Pacer pacer; //-pace, -fps.
+BlockLayer  *blockLayer = NULL; //Block field in a target texture, NULL if the renderer has no render targets.
 
-//Ball
-struct Ball
-{
-#define BALL_WIDTH  8
-#define BALL_HEIGHT 8
+Effects effects;
+JobPool jobPool; //Splitter update, -threads n.
 
-#define BALL_FRAME_X 0
-#define BALL_FRAME_Y 48
+//Particle layer, -particle-layer. Splitters rasterized on the cpu and drawn as one texture.
+bool          useParticleLayer = false;
+ParticleLayer *particleLayer   = NULL;
+SDL_Texture   *particleLayerTexture = NULL;
+unsigned int  particleLayerPalette[BLOCK_TYPES];
 
-	Vec2 pos;
-	Vec2 vel;
-	Vec2 maxVel;
-}ball;
+SDL_Texture *textureExplosion;
 
 //Score text
 struct ScoreTextures
@@ -481,19 +411,6 @@ struct ScoreTextures
 
 } scoreTextures;
 
-//Score
-struct Score
-{
-	int level;
-	int points;
-
-	float accumulator;
-
-} score;
-
-#define TIME_BETWEEN_LOWERING_BLOCKS 2000
-float timeSinceABlockWasHited;
-
 //Game over
 struct GameOver
 {
@@ -537,7 +454,9 @@ struct NextLevel
 
 } nextLevel;
 
-//Level backgrounds
+//Level backgrounds, loaded the first time a level is played and kept.
+#define LEVEL_BACKGROUNDS 3
+SDL_Texture *levelBackgroundTextures[LEVEL_BACKGROUNDS];
 SDL_Texture *currentBackgroundLevelTexture;
 #define LEVEL_BACKGROUND_WIDTH  1920
 #define LEVEL_BACKGROUND_HEIGHT 1080
@@ -576,6 +495,31 @@ Mix_Music *ballhitBlockSound;
 //PLAY END
 //******
 
+//******
+//CapturePrevTick
+//******
+void CapturePrevTick()
+{
+	prevTick.paddleX = RealToFloat(sim.paddle.pos.x);
+
+	const BallStore *balls = &sim.balls;
+	for (int i = 0; i != balls->count; ++i)
+	{
+		prevTick.ballX[i] = RealToFloat(balls->posX[i]);
+		prevTick.ballY[i] = RealToFloat(balls->posY[i]);
+	}
+	prevTick.ballCount = balls->count;
+}
+
+//******
+//Interpolate
+//******
+float Interpolate(float prev, float now, float alpha)
+{
+	if (fabsf(now - prev) > INTERPOLATE_MAX_STEP) return now;
+	return prev + (now - prev) * alpha;
+}
+
 //******
 //UpdateMenuBackground
 //******
@@ -611,321 +555,132 @@ void UpdateMenuBackground(float delta)
 }
 
 //*****
-//GameUpdate
+//PlayTick
+//One tick of play without SDL, the simulation thread runs this with -pipeline.
+//Returns a mask of SimEvent for PlayEvents.
 //*****
-void GameUpdate(float delta)
+int PlayTick(const SimInput *input, bool rewind, float delta)
 {
-	//******
-	//GAMESTATE_PLAY
-	//******
-	if (currentGameState == GAMESTATE_PLAY)
-	{
-		//paddle: Movement.
-		if (requestToMovePaddle)
-		{
-			if (paddle.vel < paddle.maxVel) paddle.vel += 0.7f;
-		}
-		else
-		{
-			(paddle.vel > 0) ? paddle.vel -= 0.9f : paddle.vel = 0.0f;
-		}
+	int events = SIM_EVENT_NONE;
 
-		//Collisiondetection Paddle vs Window.
-		if (paddle.pos.x < 0)
-		{
-			paddle.pos.x = 0;
-			paddle.vel   = 0;
-		}
-		else if (paddle.pos.x + paddle.size.x > WINDOW_WIDTH)
-		{
-			paddle.pos.x = WINDOW_WIDTH - paddle.size.x;
-			paddle.vel   = 0;
-		}
-		else
-		{
-			paddle.pos.x += paddle.vel * paddle.dir; //No collision, update movement.
-		}
-
-		//Ball: Movement.
-		//Paddle has not fired ball.
-		if (ball.vel.y == 0 && ball.vel.x == 0)
-		{
-			ball.pos = Vec2(paddle.pos.x + (paddle.size.x / 2 - (BALL_WIDTH / 2)), paddle.pos.y - BALL_HEIGHT);
-		}
-		//Movement for ball...
-		else
-		{
-			ball.pos += ball.vel;
-		}
+	//Rewind, not while recording since the replay only has forward ticks.
+	if (rewind && !replayRecorder.file)
+	{
+		simHits.count = 0;
 
-		//Collisiondetection: Ball vs Blocks
-		for (int i = 0; i != numberOfBlocks; ++i)
+		const int count = SnapshotCount(snapshots);
+		if (count > 0)
 		{
-			bool intersect = false;
-			Block *b = &blocks[i];
-			if (b->health != 0)
-			{
-				//Collision: bottom of block.
-				if ((ball.pos.x < b->pos.x + BLOCK_WIDTH && ball.pos.x > b->pos.x) && (ball.pos.y < b->pos.y + BLOCK_HEIGHT && ball.pos.y > b->pos.y))
-				{
-					ball.pos.y = b->pos.y + BLOCK_HEIGHT;
-					ball.vel.y = ball.maxVel.y;
-
-					intersect = true;
-				}
-				//Collision: Up side of block.
-				else if ((ball.pos.y + BALL_HEIGHT > b->pos.y && ball.pos.y < b->pos.y + BLOCK_HEIGHT) && (ball.pos.x < b->pos.x + BLOCK_WIDTH && ball.pos.x > b->pos.x))
-				{
-					ball.pos.y = b->pos.y - BALL_HEIGHT;
-					ball.vel.y = -ball.maxVel.y;
-
-					intersect = true;
-				}
-				//Collision: Left side of block
-				else if ((ball.pos.x + BALL_WIDTH > b->pos.x && ball.pos.x < b->pos.x + BLOCK_WIDTH) && (ball.pos.y > b->pos.y && ball.pos.y < b->pos.y + BLOCK_HEIGHT))
-				{
-					ball.pos.x = b->pos.x - BALL_WIDTH;
-					ball.vel.x = -ball.maxVel.x;
-
-					intersect = true;
-				}
-				//Collision: Right side of block
-				else if ((ball.pos.x < b->pos.x + BLOCK_WIDTH && ball.pos.x > b->pos.x) && (ball.pos.y > b->pos.y && ball.pos.y < b->pos.y + BLOCK_HEIGHT))
-				{
-					ball.pos.x = b->pos.x + BLOCK_WIDTH;
-					ball.vel.x = ball.maxVel.x;
-
-					intersect = true;
-				}
-
-				//Eval result
-				if (intersect)
-				{
-					b->health == 1 ? b->health = 0 : b->health = 1;
-
-					//If player ended block lifetime. Deactivate block and extend paddle length.
-					if (b->health == 0)
-					{
-						//Extend length.
-						if (paddle.size.x <= paddle.maxWidth)
-						{
-							paddle.size.x += PADDLE_FRAME_SIZE;
-							paddle.pos.x  -= PADDLE_FRAME_SIZE / 2;
-						}
-
-						//Increase score.
-						score.points += 1;
-
-						--numberOfActiveBLocks;
-						//Goto next level.
-						if (numberOfActiveBLocks == 0)
-						{
-							score.level == 3 ? currentGameState = GAMESTATE_COMPLETED_GAME : currentGameState = GAMESTATE_NEXT_LEVEL;
-						}
-
-						//Lower block y speed.
-						if (score.level == 3)
-						{
-							timeSinceABlockWasHited = 0.0f;
-						}
-
-						//Start explosion animation
-						b->isExplosinActive = true;
-
-						Mix_PlayMusic(explosionSound, 1); //Start explosion sound
-						Mix_FadeOutMusic(1500);
-					}
-					else if (b->health == 1 && !b->isSplitterActive)
-					{
-						b->isSplitterActive = true; //activate splitter.
-
-						if (!Mix_PlayingMusic()) Mix_PlayMusic(ballhitBlockSound, 1); //Play sound.
-					}
-
-					//Check if block is of type 1, in that case apply extra energy to ball.
-					if (b->type == 0)
-					{
-						ball.vel.x > 0 ? ball.vel.x *= 2 : ball.vel.y *= 2;
-					}
-
-					break;
-				}
-			}
+			CapturePrevTick();
+			SnapshotRewind(snapshots, count < REWIND_TICKS_PER_TICK ? count : REWIND_TICKS_PER_TICK, &sim);
+			scoreTextures.requestUpdatePoints = true;
+			FrameResetBlocks(tickFrame);
 		}
+	}
+	else
+	{
+		CapturePrevTick();
+		ReplayRecordTick(&replayRecorder, input);
+		events = SimStep(&sim, input, &simHits);
+		SnapshotPush(snapshots, &sim);
+	}
 
-		//Collisiondetection: Ball vs paddle
-		if (ball.pos.y + BALL_HEIGHT > paddle.pos.y && paddle.pos.x < ball.pos.x + BALL_WIDTH && paddle.pos.x + paddle.size.x > ball.pos.x)
-		{
-			//Percentage.
-			const float w = paddle.pos.x + paddle.size.x - (ball.pos.x + (BALL_WIDTH / 2));
-			paddle.angle  = (w / paddle.size.x - 0.5f); // 0.5 -> -0.5
-
-			if (paddle.angle < 0.1f && paddle.angle > -0.1f) paddle.angle = 0.0f; //Middle
-			else paddle.angle > 0.1f ? paddle.angle -= 1.0 : paddle.angle += 1.0f; //Left or Right.
+	//Splitter, Explosion
+	for (int i = 0; i != simHits.count; ++i)
+	{
+		EffectsBlockHit(&effects, &sim.blocks, simHits.block[i], simHits.health[i]);
+		FrameMarkBlock(tickFrame, simHits.block[i]);
+	}
+	EffectsUpdate(&effects, delta);
 
-			ball.vel.x = ball.maxVel.x * paddle.angle;
-			ball.vel.y = -ball.maxVel.y;
+	return events;
+}
 
-			Mix_HaltMusic(); //This wil cause issues, when blocks are closer paddle.
-			if (!Mix_PlayingMusic())
-			{
-				Mix_PlayMusic(ballHitPaddleSound, 1); //Play sound.
-			}
-		}
+//*****
+//PlayEvents
+//Sounds, state changes and score text for what PlayTick returned. Main thread only.
+//*****
+void PlayEvents(int events)
+{
+	//Sounds
+	if (events & SIM_EVENT_BLOCK_DESTROYED)
+	{
+		Mix_PlayMusic(explosionSound, 1); //Start explosion sound
+		Mix_FadeOutMusic(1500);
 
-		//Collisiondetection: Ball vs window sides
-		//Bottom (Game over)
-		if (ball.pos.y + BALL_HEIGHT > WINDOW_HEIGHT)
-		{
-			currentGameState = GAMESTATE_GAME_OVER;
-		}
-		//Top
-		else if (ball.pos.y < 0)
-		{
-			ball.vel.y = ball.maxVel.y;
-			ball.pos.y = 0;
-		}
-		//Right
-		else if (ball.pos.x + BALL_WIDTH > WINDOW_WIDTH)
-		{
-			ball.vel.x = -ball.maxVel.x * paddle.angle;
-			ball.pos.x = WINDOW_WIDTH - BALL_WIDTH;
-		}
-		//Left
-		else if (ball.pos.x < 0)
-		{
-			ball.vel.x = ball.maxVel.x * -paddle.angle;
-			ball.pos.x = 0;
-		}
+		scoreTextures.requestUpdatePoints = true;
+	}
+	else if (events & SIM_EVENT_BLOCK_HIT)
+	{
+		if (!Mix_PlayingMusic()) Mix_PlayMusic(ballhitBlockSound, 1); //Play sound.
+	}
 
-		//Things attached to a Block (Splitter, Explosion).
-		for (int i = 0; i != numberOfBlocks; ++i)
+	if (events & SIM_EVENT_PADDLE_HIT)
+	{
+		Mix_HaltMusic(); //This wil cause issues, when blocks are closer paddle.
+		if (!Mix_PlayingMusic())
 		{
-			//Splitter
-			if (blocks[i].isSplitterActive)
-			{
-				for (int k = 0; k != MAX_NUMBER_OF_SPLITTER; ++k)
-				{
-					Splitter *s = &blocks[i].blockSplitter[k];
-					if ( (s->pos.x + s->size.x) < WINDOW_WIDTH  && s->pos.x > 0 &&
-						 (s->pos.y + s->size.y) < WINDOW_HEIGHT && s->pos.y > 0
-					   ) 
-					{		
-						float deltaVel = delta * GRAVITY / 1000;
-
-						s->pos.y += s->vel.y + (deltaVel / 2) * delta * s->acc.y;
-						s->pos.x += s->vel.x + (deltaVel / 2) * delta * s->acc.x;
-
-						s->vel.y += deltaVel;
-					}
-				}
-			}
-			//Explosion
-			Explosion *e = &blocks[i].explosion;
-			if (blocks[i].isExplosinActive)
-			{
-				e->timeToNextFrame -= delta;
-				if (e->timeToNextFrame <= 0)
-				{
-					e->timeToNextFrame = EXPLOSION_TIME_BETWEEN_FRAMES;
-
-					e->frame.x == EXPLOSION_MAX_FRAME_X ? e->frame.x = 0, ++e->frame.y : ++e->frame.x;
-
-					if(e->frame.y == EXPLOSION_MAX_FRAME_Y) blocks[i].isExplosinActive = false; //Stop explosion animation.
-				}
-			}
+			Mix_PlayMusic(ballHitPaddleSound, 1); //Play sound.
 		}
+	}
 
-		//Textures
-		//Update, Texture: Level.
-		if (scoreTextures.requestUpdateLevel)
-		{
-			sprintf(scoreTextures.textLevel, "Level:  %d", score.level);
+	//States
+	if (events & SIM_EVENT_GAME_COMPLETED) currentGameState = GAMESTATE_COMPLETED_GAME;
+	if (events & SIM_EVENT_LEVEL_COMPLETED) currentGameState = GAMESTATE_NEXT_LEVEL;
+	if (events & SIM_EVENT_GAME_OVER) currentGameState = GAMESTATE_GAME_OVER;
 
-			//Remove old before creating new.
-			SDL_DestroyTexture(scoreTextures.levelShadowTexture);
-			SDL_DestroyTexture(scoreTextures.levelTexture);
-			scoreTextures.levelShadowTexture = NULL;
-			scoreTextures.levelTexture       = NULL;
+	//Textures
+	//Update, Texture: Level.
+	if (scoreTextures.requestUpdateLevel)
+	{
+		sprintf(scoreTextures.textLevel, "Level:  %d", sim.score.level);
 
-			scoreTextures.levelTexture       = CreateTextTexture(sdlRenderer, fontArial24, scoreTextures.originColor, scoreTextures.textLevel); //Level: Origin
-			scoreTextures.levelShadowTexture = CreateTextTexture(sdlRenderer, fontArial24, scoreTextures.shadowColor, scoreTextures.textLevel); //Level: Shadow
-		}
+		//Remove old before creating new.
+		SDL_DestroyTexture(scoreTextures.levelShadowTexture);
+		SDL_DestroyTexture(scoreTextures.levelTexture);
+		scoreTextures.levelShadowTexture = NULL;
+		scoreTextures.levelTexture       = NULL;
 
-		//Update,Texture: Points
-		if (scoreTextures.requestUpdatePoints)
-		{
-			sprintf(scoreTextures.textPoints, "Score: %d", score.points);
+		scoreTextures.levelTexture       = CreateTextTexture(sdlRenderer, fontArial24, scoreTextures.originColor, scoreTextures.textLevel); //Level: Origin
+		scoreTextures.levelShadowTexture = CreateTextTexture(sdlRenderer, fontArial24, scoreTextures.shadowColor, scoreTextures.textLevel); //Level: Shadow
 
-			//Remove old before creating new.
-			SDL_DestroyTexture(scoreTextures.pointsShadowTexture);
-			SDL_DestroyTexture(scoreTextures.pointsTexture);
-			scoreTextures.pointsShadowTexture = NULL;
-			scoreTextures.pointsTexture       = NULL;
+		scoreTextures.requestUpdateLevel = false;
+	}
 
-			scoreTextures.pointsTexture       = CreateTextTexture(sdlRenderer, fontArial24, scoreTextures.originColor, scoreTextures.textPoints); //Points: Origin
-			scoreTextures.pointsShadowTexture = CreateTextTexture(sdlRenderer, fontArial24, scoreTextures.shadowColor, scoreTextures.textPoints); //Points: Shadow
-		}
+	//Update,Texture: Points
+	if (scoreTextures.requestUpdatePoints)
+	{
+		sprintf(scoreTextures.textPoints, "Score: %d", sim.score.points);
 
-		//Level
-		//Level: 1
-		//Do nothing special.
-		if (score.level == 1)
-		{
-			
-		}
-		//Level: 2
-		else if (score.level == 2)
-		{
-			//Lower blocks (constant speed).
-			score.accumulator += delta;
-			if (score.accumulator > TIME_BETWEEN_LOWERING_BLOCKS)
-			{
-				score.accumulator = 0.0f;
+		//Remove old before creating new.
+		SDL_DestroyTexture(scoreTextures.pointsShadowTexture);
+		SDL_DestroyTexture(scoreTextures.pointsTexture);
+		scoreTextures.pointsShadowTexture = NULL;
+		scoreTextures.pointsTexture       = NULL;
 
-				if (blocks[numberOfBlocks -1].pos.y > paddle.pos.y - (paddle.size.y * 6))
-				{
-					currentGameState = GAMESTATE_GAME_OVER;
-				}
-				else
-				{
-					for (int i = 0; i != numberOfBlocks; ++i)
-					{
-						blocks[i].pos.y += 10;
-					}
-				}
-			}
-		}
-		//Level: 3
-		else if (score.level == 3)
-		{
-			//Lower blocks (increase speed if failing to kill any block).
-			score.accumulator += delta;
-			if (score.accumulator > TIME_BETWEEN_LOWERING_BLOCKS)
-			{
-				score.accumulator = 0.0f;
+		scoreTextures.pointsTexture       = CreateTextTexture(sdlRenderer, fontArial24, scoreTextures.originColor, scoreTextures.textPoints); //Points: Origin
+		scoreTextures.pointsShadowTexture = CreateTextTexture(sdlRenderer, fontArial24, scoreTextures.shadowColor, scoreTextures.textPoints); //Points: Shadow
 
-				if (blocks[numberOfBlocks - 1].pos.y > paddle.pos.y - (paddle.size.y * 6))
-				{
-					currentGameState = GAMESTATE_GAME_OVER;
-				}
-				else
-				{
-					for (int i = 0; i != numberOfBlocks; ++i)
-					{
-						blocks[i].pos.y += 10;
-					}
-				}
-			}
+		scoreTextures.requestUpdatePoints = false;
+	}
+}
 
-			//Increase speed.
-			timeSinceABlockWasHited += delta;
-			if (timeSinceABlockWasHited > (TIME_BETWEEN_LOWERING_BLOCKS * 2))
-			{
-				score.accumulator += delta;
-			}
-		}
+//*****
+//GameUpdate
+//*****
+void GameUpdate(float delta)
+{
+	//******
+	//GAMESTATE_PLAY
+	//******
+	if (currentGameState == GAMESTATE_PLAY)
+	{
+		simInput.moveDir = requestToMovePaddle ? paddleDir : 0;
 
+		const int events = PlayTick(&simInput, requestRewind, delta);
+		simInput.fireBall = false;
+
+		PlayEvents(events);
 	}
 	//******
 	//GAMESTATE_NEXT_LEVEL
@@ -935,7 +690,7 @@ void GameUpdate(float delta)
 		nextLevel.accumulator += delta;
 		if (nextLevel.accumulator > TIME_TO_SHOW_NEXT_LEVEL)
 		{
-			score.level++;
+			sim.score.level++;
 
 			currentGameState = GAMESTATE_NONE;
 			currentMenuState = MENUSTATE_NEW_GAME; //Goto next level.
@@ -949,7 +704,7 @@ void GameUpdate(float delta)
 		gameOver.accumulator += delta;
 		if (gameOver.accumulator > TIME_TO_SHOW_GAME_OVER)
 		{
-			score.level = 1;
+			sim.score.level = 1;
 
 			currentGameState = GAMESTATE_MENU;
 			currentMenuState = MENUSTATE_NONE;
@@ -971,7 +726,7 @@ void GameUpdate(float delta)
 		completedGame.accumulator += delta;
 		if (completedGame.accumulator > TIME_TO_SHOW_COMPLETED_GAME)
 		{
-			score.level = 1;
+			sim.score.level = 1;
 
 			currentGameState = GAMESTATE_MENU;
 			currentMenuState = MENUSTATE_NONE;
@@ -1071,9 +826,16 @@ void GameUpdate(float delta)
 	//******
 	else if (currentMenuState == MENUSTATE_NEW_GAME)
 	{
-		//Score
-		score.accumulator = 0.0f;
-		score.points      = 0;
+		//Paddle, ball and blocks.
+		ReplayRecordLevel(&replayRecorder, sim.score.level);
+		SimStartLevel(&sim);
+		EffectsStartLevel(&effects);
+		CapturePrevTick();
+		if (blockLayer) BlockLayerInvalidate(blockLayer);
+
+		//Rewind stops at the start of the level.
+		SnapshotClear(snapshots);
+		SnapshotPush(snapshots, &sim);
 
 		//Score textures
 		scoreTextures.requestUpdatePoints = true;
@@ -1085,67 +847,9 @@ void GameUpdate(float delta)
 		//Completed game
 		completedGame.accumulator = 0.0f;
 
-		//paddle
-		paddle.pos   = Vec2((WINDOW_WIDTH / 2) - (paddle.size.x / 2), WINDOW_HEIGHT - PADDLE_FRAME_SIZE);
-		paddle.size  = Vec2(PADDLE_START_WIDTH, PADDLE_START_HEIGHT);
-		paddle.vel   = 0.0f;
-		paddle.dir   = 0;
-		paddle.angle = 0.0f;
-
-		//Ball	
-		ball.vel = Vec2(0.0f, 0.0f);
-
-		//Level
-		timeSinceABlockWasHited = 0.0f;
-
 		//Next level
 		nextLevel.accumulator = 0.0f;
 
-		//Blocks
-		const int length = blockMaxColumns * blockMaxRows -blockOffsetX;
-		numberOfBlocks   = length - (length % blockMaxRows);
-
-		blocks = DBG_NEW Block[numberOfBlocks];
-
-		int x = blockOffsetX;
-		int y = blockOffsetY;
-		for (int i = 0; i != numberOfBlocks; ++i)
-		{
-			Block *b = &blocks[i];
-
-			b->type   = rand() % 4;
-			b->health = 2;
-
-			//Block position
-			if (x == blockMaxColumns)
-			{
-				++y;
-				x = blockOffsetX;
-			}
-			b->pos = Vec2(x++ * BLOCK_WIDTH, y * BLOCK_HEIGHT);
-
-			//Splitter
-			b->isSplitterActive = false;
-			for (int i = 0; i != MAX_NUMBER_OF_SPLITTER; ++i)
-			{
-				memcpy(&b->blockSplitter[i].color, &blockSplitterColor[b->type], sizeof(Color));
-				memcpy(&b->blockSplitter[i].size,  &Vec2(2.0f, 2.0f), sizeof(Vec2));
-				memcpy(&b->blockSplitter[i].pos,   &b->pos, sizeof(Vec2));
-				memcpy(&b->blockSplitter[i].vel,   &Vec2(InRange(-0.1f, 0.3f), InRange(-6.0f, -4.0f)), sizeof(Vec2));
-				memcpy(&b->blockSplitter[i].acc,   &Vec2(InRange(-0.8f, 0.8f), InRange(-0.8f, 0.8f)),  sizeof(Vec2));
-			}
-
-			//Explosion
-			b->isExplosinActive = false;
-
-			b->explosion.frame           = Vec2(0.0f, 0.0f);
-			b->explosion.timeToNextFrame = EXPLOSION_TIME_BETWEEN_FRAMES;
-
-			b->explosion.pos = Vec2(b->pos.x - (EXPLOSION_WIDTH / 2) + (BLOCK_WIDTH / 2), b->pos.y - (EXPLOSION_HEIGHT / 2) + (BLOCK_HEIGHT / 2) );
-		}
-
-		numberOfActiveBLocks = numberOfBlocks; //Counter, used for level up.
-
 		//set states
 		currentGameState = GAMESTATE_PLAY;
 		currentMenuState = MENUSTATE_NONE;
@@ -1153,18 +857,14 @@ void GameUpdate(float delta)
 		gameIsStarted = true;
 
 		//Set Background.
-		if (score.level == 1)
-		{
-			currentBackgroundLevelTexture = LoadTextureFromFile(sdlRenderer, "../res/images/background_level_1.png");
-		}
-		else if (score.level == 2)
-		{
-			currentBackgroundLevelTexture = LoadTextureFromFile(sdlRenderer, "../res/images/background_level_2.png");
-		}
-		else
+		const int background = sim.score.level >= 1 && sim.score.level <= LEVEL_BACKGROUNDS ? sim.score.level - 1 : LEVEL_BACKGROUNDS - 1;
+		if (!levelBackgroundTextures[background])
 		{
-			currentBackgroundLevelTexture = LoadTextureFromFile(sdlRenderer, "../res/images/background_level_3.png");
+			char path[MAX_TEXT_LENGTH];
+			snprintf(path, MAX_TEXT_LENGTH, "../res/images/background_level_%d.png", background + 1);
+			levelBackgroundTextures[background] = LoadTextureFromFile(sdlRenderer, path);
 		}
+		currentBackgroundLevelTexture = levelBackgroundTextures[background];
 
 		//Menu: Continue
 		menu.continueGame.pos = { WINDOW_WIDTH / 2.0f - menu.continueGame.size.x / 2.0f, menu.newGame.pos.y + menu.newGame.size.y + MENU_OFFSET_Y };
@@ -1228,70 +928,155 @@ void GameUpdate(float delta)
 }
 
 //******
-//Gamerenderer
+//BuildFrame
+//Play sprites from sim and effects, alpha of the way from the tick before to the last one.
 //******
-void GameRenderer(SDL_Renderer *renderer)
+void BuildFrame(FrameState *frame, float alpha)
 {
-	SDL_SetRenderDrawColor(renderer, 50, 50, 50, 255);
-	SDL_RenderClear(renderer);
+	FrameBegin(frame);
 
-	//******
-	//Play
-	//******
-	if (currentGameState == GAMESTATE_PLAY)
+	//Background
+	FrameAddSprite(frame, SPRITE_LAYER_BACKGROUND, FRAME_TEXTURE_BACKGROUND, Vec2(0, 0), Vec2(WINDOW_WIDTH, WINDOW_HEIGHT), Vec2(LEVEL_BACKGROUND_WIDTH / 6, abs(LEVEL_BACKGROUND_HEIGHT - WINDOW_HEIGHT)));
+
+	//paddle
+	const Vec2 paddlePos  = Vec2(Interpolate(prevTick.paddleX, RealToFloat(sim.paddle.pos.x), alpha), RealToFloat(sim.paddle.pos.y));
+	const Vec2 paddleSize = RealToVec2(sim.paddle.size);
+	FrameAddSprite(frame, SPRITE_LAYER_PADDLE, FRAME_TEXTURE_SPRITE_SHEET, Vec2(paddlePos.x, paddlePos.y), Vec2( (PADDLE_START_WIDTH / 3), PADDLE_FRAME_SIZE), Vec2(0, PADDLE_FRAME_SIZE * 2)); //Left
+
+	const float midSize = ( paddleSize.x - (PADDLE_START_WIDTH / 3) * 2);
+	for (int i = 1; i <= midSize / PADDLE_FRAME_SIZE; ++i)
+	{
+		FrameAddSprite(frame, SPRITE_LAYER_PADDLE, FRAME_TEXTURE_SPRITE_SHEET, Vec2(paddlePos.x + ( (PADDLE_START_WIDTH / 3) *i), paddlePos.y), Vec2(PADDLE_FRAME_SIZE, PADDLE_FRAME_SIZE), Vec2(PADDLE_FRAME_SIZE, PADDLE_FRAME_SIZE * 2)); //Mid
+	}
+
+	FrameAddSprite(frame, SPRITE_LAYER_PADDLE, FRAME_TEXTURE_SPRITE_SHEET, Vec2(paddlePos.x + (PADDLE_START_WIDTH / 3) + midSize, paddlePos.y), Vec2((PADDLE_START_WIDTH / 3), PADDLE_FRAME_SIZE), Vec2(PADDLE_FRAME_SIZE * 2, PADDLE_FRAME_SIZE * 2)); //Right
+
+	//Balls
+	const BallStore *balls = &sim.balls;
+	for (int i = 0; i != balls->count; ++i)
 	{
-		//Background
-		SpriteDraw(sdlRenderer, currentBackgroundLevelTexture, Vec2(0, 0), Vec2(WINDOW_WIDTH, WINDOW_HEIGHT), Vec2(LEVEL_BACKGROUND_WIDTH / 6, abs(LEVEL_BACKGROUND_HEIGHT - WINDOW_HEIGHT)), globalScale);
+		Vec2 ballPos = Vec2(RealToFloat(balls->posX[i]), RealToFloat(balls->posY[i]));
+		if (i < prevTick.ballCount) ballPos = Vec2(Interpolate(prevTick.ballX[i], ballPos.x, alpha), Interpolate(prevTick.ballY[i], ballPos.y, alpha));
 
-		//paddle
-		SpriteDraw(sdlRenderer, spriteSheet, Vec2(paddle.pos.x, paddle.pos.y), Vec2( (PADDLE_START_WIDTH / 3), PADDLE_FRAME_SIZE), Vec2(0, PADDLE_FRAME_SIZE * 2), globalScale); //Left
+		FrameAddSprite(frame, SPRITE_LAYER_BALLS, FRAME_TEXTURE_SPRITE_SHEET, ballPos, Vec2(BALL_WIDTH, BALL_HEIGHT), Vec2(BALL_FRAME_X, BALL_FRAME_Y));
+	}
 
-		const float midSize = ( paddle.size.x - (PADDLE_START_WIDTH / 3) * 2);
-		for (int i = 1; i <= midSize / PADDLE_FRAME_SIZE; ++i)
+	//Blocks
+	const BlockStore *blocks = &sim.blocks;
+	if (blockLayer)
+	{
+		FrameAddSprite(frame, SPRITE_LAYER_BLOCKS, FRAME_TEXTURE_BLOCK_LAYER, Vec2(0, RealToFloat(blocks->offsetY)), Vec2(BLOCK_LAYER_WIDTH, BLOCK_LAYER_HEIGHT), Vec2(0, 0));
+	}
+	else
+	{
+		for (int n = 0; n != blocks->liveCount; ++n)
 		{
-			SpriteDraw(sdlRenderer, spriteSheet, Vec2(paddle.pos.x + ( (PADDLE_START_WIDTH / 3) *i), paddle.pos.y), Vec2(PADDLE_FRAME_SIZE, PADDLE_FRAME_SIZE), Vec2(PADDLE_FRAME_SIZE, PADDLE_FRAME_SIZE * 2), globalScale); //Mid
+			const int i = blocks->live[n];
+
+			int frameY;
+			blocks->health[i] == 1 ? frameY = BLOCK_HEIGHT : frameY = 0;
+			FrameAddSprite(frame, SPRITE_LAYER_BLOCKS, FRAME_TEXTURE_SPRITE_SHEET, Vec2(RealToFloat(blocks->posX[i]), RealToFloat(BlockY(blocks, i))), Vec2(BLOCK_WIDTH, BLOCK_HEIGHT), Vec2(BLOCK_WIDTH * blocks->type[i], frameY));
 		}
+	}
+
+	//Splitter
+	frame->splitters = EffectsSplitters(&effects, alpha);
+
+	//Explosion
+	const AnimationPool *explosions = &effects.explosions;
+	for (int i = 0; i != explosions->count; ++i)
+	{
+		const Vec2 sheetFrame = AnimationSheetFrame(explosions, i);
+		FrameAddSprite(frame, SPRITE_LAYER_EFFECTS, FRAME_TEXTURE_EXPLOSION, explosions->pos[i], Vec2(EXPLOSION_WIDTH, EXPLOSION_HEIGHT),
+			Vec2(sheetFrame.x * EXPLOSION_WIDTH, sheetFrame.y * EXPLOSION_HEIGHT));
+	}
+}
+
+//******
+//AddFrameSprites
+//Frame sprites on layers [minLayer, maxLayer) to the sprite batch.
+//******
+void AddFrameSprites(const FrameState *frame, int minLayer, int maxLayer)
+{
+	SDL_Texture *textures[FRAME_TEXTURES];
+	textures[FRAME_TEXTURE_BACKGROUND]   = currentBackgroundLevelTexture;
+	textures[FRAME_TEXTURE_SPRITE_SHEET] = spriteSheet;
+	textures[FRAME_TEXTURE_BLOCK_LAYER]  = blockLayer ? blockLayer->texture : NULL;
+	textures[FRAME_TEXTURE_EXPLOSION]    = textureExplosion;
 
-		SpriteDraw(sdlRenderer, spriteSheet, Vec2(paddle.pos.x + (PADDLE_START_WIDTH / 3) + midSize, paddle.pos.y), Vec2((PADDLE_START_WIDTH / 3), PADDLE_FRAME_SIZE), Vec2(PADDLE_FRAME_SIZE * 2, PADDLE_FRAME_SIZE * 2), globalScale); //Right
+	for (int i = 0; i != frame->numSprites; ++i)
+	{
+		const FrameSprite *sprite = &frame->sprites[i];
+		if (sprite->layer < minLayer || sprite->layer >= maxLayer) continue;
 
+		SpriteBatchAdd(spriteBatch, sdlRenderer, (SpriteLayer)sprite->layer, textures[sprite->texture], sprite->pos, sprite->size, sprite->frame, globalScale);
+	}
+}
 
-		//Ball
-		SpriteDraw(sdlRenderer, spriteSheet, ball.pos, Vec2(BALL_WIDTH, BALL_HEIGHT), Vec2(BALL_FRAME_X, BALL_FRAME_Y), globalScale);
+//******
+//Gamerenderer
+//Play is drawn from frame, blocks are the ones the frame was built from.
+//******
+void GameRenderer(SDL_Renderer *renderer, FrameState *frame, const BlockStore *blocks)
+{
+	drawStats.calls           = 1;
+	drawStats.textureSwitches = 0;
+	drawStats.lastTexture     = NULL;
 
-		//Blocks
-		for (int i = 0; i != numberOfBlocks; ++i)
+	//Switches render target, before anything is drawn to the window.
+	if (currentGameState == GAMESTATE_PLAY)
+	{
+		if (blockLayer)
 		{
-			Block *b = &blocks[i];
-			//Block
-			if (b->health != 0)
+			if (frame->blocksReset) BlockLayerInvalidate(blockLayer);
+			for (int i = 0; i != frame->numDirtyBlocks; ++i)
 			{
-				int frameY;
-				b->health == 1 ? frameY = BLOCK_HEIGHT : frameY = 0;
-				SpriteDraw(sdlRenderer, spriteSheet, b->pos, Vec2(BLOCK_WIDTH, BLOCK_HEIGHT), Vec2(BLOCK_WIDTH * b->type, frameY), globalScale);
+				BlockLayerMarkDirty(blockLayer, blocks, frame->dirtyBlocks[i]);
 			}
 
-			//Splitter
-			if (b->isSplitterActive)
-			{
-				for (int k = 0; k != MAX_NUMBER_OF_SPLITTER; ++k)
-				{
-					if ((b->blockSplitter[k].pos.x + b->blockSplitter[k].size.x) < WINDOW_WIDTH  && b->blockSplitter[k].pos.x > 0 &&
-						(b->blockSplitter[k].pos.y + b->blockSplitter[k].size.y) < WINDOW_HEIGHT && b->blockSplitter[k].pos.y > 0
-						)
-					{
-						DrawFilledRectangle(sdlRenderer, b->blockSplitter[k].color, b->blockSplitter[k].pos.x, b->blockSplitter[k].pos.y, b->blockSplitter[k].size.x, b->blockSplitter[k].size.y);
-					}
-				}
-			}
+			BlockLayerUpdate(blockLayer, renderer, blocks);
+			drawStats.calls += blockLayer->drawCalls;
+		}
+		FrameClearBlocks(frame);
+	}
+
+	SDL_SetRenderDrawColor(renderer, 50, 50, 50, 255);
+	SDL_RenderClear(renderer);
+
+	//******
+	//Play
+	//******
+	if (currentGameState == GAMESTATE_PLAY)
+	{
+		SpriteBatchBeginFrame(spriteBatch);
+
+		//Everything up to the blocks goes under the splitters.
+		AddFrameSprites(frame, SPRITE_LAYER_BACKGROUND, SPRITE_LAYER_EFFECTS);
+		SpriteBatchFlush(spriteBatch, sdlRenderer);
 
-			//Explosion
-			if (b->isExplosinActive)
+		//Splitter
+		const ParticlePool *splitters = frame->splitters;
+		drawStats.particles = splitters ? splitters->count : 0;
+		if (useParticleLayer)
+		{
+			ParticleLayerDraw(particleLayer, splitters, particleLayerPalette);
+			if (particleLayer->uploadEnd > particleLayer->uploadBegin)
 			{
-				SpriteDraw(sdlRenderer, textureExplosion, b->explosion.pos, Vec2(EXPLOSION_WIDTH, EXPLOSION_HEIGHT),
-					Vec2(b->explosion.frame.x * EXPLOSION_WIDTH, b->explosion.frame.y * EXPLOSION_HEIGHT),  globalScale );
+				const SDL_Rect rows = { 0, particleLayer->uploadBegin, PARTICLE_LAYER_WIDTH, particleLayer->uploadEnd - particleLayer->uploadBegin };
+				SDL_UpdateTexture(particleLayerTexture, &rows, particleLayer->pixels + rows.y * PARTICLE_LAYER_WIDTH, PARTICLE_LAYER_WIDTH * sizeof(unsigned int));
 			}
+
+			++drawStats.calls;
+			SDL_RenderCopy(sdlRenderer, particleLayerTexture, NULL, NULL);
+		}
+		else
+		{
+			if (splitters) DrawParticles(sdlRenderer, splitters, effects.blockSplitterColor, BLOCK_TYPES);
 		}
 
+		//Explosion
+		AddFrameSprites(frame, SPRITE_LAYER_EFFECTS, SPRITE_LAYER_TEXT_SHADOW);
+
 		//Textures
 		int offsetX = 10;
 		int offsetY = 20;
@@ -1302,8 +1087,8 @@ void GameRenderer(SDL_Renderer *renderer)
 		if (scoreTextures.levelTexture)
 		{
 			SDL_QueryTexture(scoreTextures.levelTexture, NULL, NULL, &levelWidth, &levelHeigth);
-			SpriteDraw(sdlRenderer, scoreTextures.levelShadowTexture, Vec2(offsetX, offsetY) - shadowOffset, Vec2(levelWidth, levelHeigth), Vec2(0, 0), globalScale); //Shadow
-			SpriteDraw(sdlRenderer, scoreTextures.levelTexture, Vec2(offsetX, offsetY), Vec2(levelWidth, levelHeigth), Vec2(0, 0), globalScale); //Origin
+			SpriteBatchAdd(spriteBatch, sdlRenderer, SPRITE_LAYER_TEXT_SHADOW, scoreTextures.levelShadowTexture, Vec2(offsetX, offsetY) - shadowOffset, Vec2(levelWidth, levelHeigth), Vec2(0, 0), globalScale); //Shadow
+			SpriteBatchAdd(spriteBatch, sdlRenderer, SPRITE_LAYER_TEXT, scoreTextures.levelTexture, Vec2(offsetX, offsetY), Vec2(levelWidth, levelHeigth), Vec2(0, 0), globalScale); //Origin
 		}
 
 		//Textures: Score
@@ -1311,10 +1096,14 @@ void GameRenderer(SDL_Renderer *renderer)
 		if (scoreTextures.pointsTexture)
 		{
 			SDL_QueryTexture(scoreTextures.pointsTexture, NULL, NULL, &scoreWidth, &scoreHeigth);
-			SpriteDraw(sdlRenderer, scoreTextures.pointsShadowTexture, Vec2(offsetX, levelHeigth + offsetY) - shadowOffset, Vec2(scoreWidth, scoreHeigth), Vec2(0, 0), globalScale); //Shadow
-			SpriteDraw(sdlRenderer, scoreTextures.pointsTexture, Vec2(offsetX, levelHeigth + offsetY), Vec2(scoreWidth, scoreHeigth), Vec2(0, 0), globalScale); //Origin
+			SpriteBatchAdd(spriteBatch, sdlRenderer, SPRITE_LAYER_TEXT_SHADOW, scoreTextures.pointsShadowTexture, Vec2(offsetX, levelHeigth + offsetY) - shadowOffset, Vec2(scoreWidth, scoreHeigth), Vec2(0, 0), globalScale); //Shadow
+			SpriteBatchAdd(spriteBatch, sdlRenderer, SPRITE_LAYER_TEXT, scoreTextures.pointsTexture, Vec2(offsetX, levelHeigth + offsetY), Vec2(scoreWidth, scoreHeigth), Vec2(0, 0), globalScale); //Origin
 		}
 
+		SpriteBatchFlush(spriteBatch, sdlRenderer);
+		drawStats.calls           += spriteBatch->drawCalls;
+		drawStats.textureSwitches += spriteBatch->textureSwitches;
+
 	}
 	//******
 	//GAMESTATE_NEXT_LEVEL
@@ -1421,17 +1210,263 @@ void GameRenderer(SDL_Renderer *renderer)
 	}
 
 	SDL_RenderPresent(renderer);
+
+	drawStats.lastCalls           = drawStats.calls;
+	drawStats.lastTextureSwitches = drawStats.textureSwitches;
+}
+
+//******
+//HandleEvent
+//******
+void HandleEvent(const SDL_Event *event)
+{
+	switch (event->type)
+	{
+		case SDL_KEYDOWN:
+			switch (event->key.keysym.sym)
+			{
+				case SDLK_LEFT:
+					paddleDir = -1;
+					requestToMovePaddle = true;
+					break;
+
+				case SDLK_RIGHT:
+					paddleDir = 1;
+					requestToMovePaddle = true;
+					break;
+
+				case SDLK_UP:
+					simInput.fireBall = true;
+					break;
+
+				case SDLK_BACKSPACE:
+					requestRewind = true;
+					break;
+
+				case SDLK_ESCAPE:
+					if (currentGameState == GAMESTATE_PLAY)
+					{
+						currentGameState = GAMESTATE_MENU;
+						currentMenuState = MENUSTATE_NONE;
+					}
+					break;
+			}
+		break;
+		case SDL_KEYUP:
+			switch (event->key.keysym.sym)
+			{
+				case SDLK_LEFT:
+					requestToMovePaddle = false;
+					break;
+
+				case SDLK_RIGHT:
+					requestToMovePaddle = false;
+					break;
+
+				case SDLK_BACKSPACE:
+					requestRewind = false;
+					break;
+			}
+			break;
+		case SDL_MOUSEBUTTONDOWN:
+			if (event->button.clicks == SDL_BUTTON_LEFT) isLeftMouseBtnClicked = true;
+			break;
+		case SDL_MOUSEBUTTONUP:
+			if (isLeftMouseBtnClicked) isLeftMouseBtnClicked = false;
+			break;
+		case SDL_QUIT:
+			currentMenuState = MENUSTATE_EXIT;
+			break;
+
+		case SDL_RENDER_TARGETS_RESET:
+			if (blockLayer) BlockLayerEvent(blockLayer, event);
+			break;
+	}
+}
+
+//******
+//SimJobRun
+//Simulation thread. The main thread keeps away from sim and effects until JobThreadWait.
+//******
+void SimJobRun(void *data, int)
+{
+	SimJob *job = (SimJob *)data;
+	tickFrame = job->frame;
+
+	job->events = SIM_EVENT_NONE;
+
+	SimInput input = job->input;
+	for (int i = 0; i != job->ticks; ++i)
+	{
+		job->events |= PlayTick(&input, job->rewind, TIME_STEP);
+		input.fireBall = false;
+
+		//The main thread leaves play on these, the rest of the ticks belong to the next state.
+		if (job->events & (SIM_EVENT_GAME_OVER | SIM_EVENT_LEVEL_COMPLETED | SIM_EVENT_GAME_COMPLETED)) break;
+	}
+
+	BuildFrame(job->frame, job->alpha);
+	FrameCopySplitters(job->frame);
+	FrameCopyBlocks(job->frame, &sim.blocks);
+}
+
+//******
+//PipelinedPass
+//One pass of the game loop in play with -pipeline. Input is polled once for every tick of the pass.
+//Returns true if a frame was drawn.
+//******
+bool PipelinedPass(float *accumulator)
+{
+	SDL_Event event;
+	while (SDL_PollEvent(&event)) HandleEvent(&event);
+	if (currentGameState != GAMESTATE_PLAY) return false;
+
+	simJob.frame = frames[1 - frontFrame];
+	simJob.ticks = 0;
+	while (*accumulator >= TIME_STEP)
+	{
+		*accumulator -= TIME_STEP;
+		++simJob.ticks;
+	}
+	simJob.input.moveDir  = requestToMovePaddle ? paddleDir : 0;
+	simJob.input.fireBall = simInput.fireBall;
+	simJob.rewind = requestRewind;
+	simJob.alpha  = *accumulator / TIME_STEP;
+	if (simJob.ticks > 0) simInput.fireBall = false;
+
+	JobThreadStart(&simThread, SimJobRun, &simJob);
+
+	//Draw what the pass before built while this one is simulated.
+	FrameState *front = frames[frontFrame];
+	if (frontFrameReady) GameRenderer(sdlRenderer, front, &front->blocks);
+
+	JobThreadWait(&simThread);
+
+	PlayEvents(simJob.events);
+
+	const bool drawn = frontFrameReady;
+	frontFrame = 1 - frontFrame;
+	frontFrameReady = true;
+	return drawn;
 }
 
 #undef main // Fuck that SDL main macro, R.I.P.
 //******
 //main
 //******
-int main()
+int main(int argc, char **argv)
 {
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 
-	srand(time(NULL));
+	unsigned int seed = (unsigned int)time(NULL);
+
+	//Command line.
+	//-multiball                         Every destroyed block releases a new ball.
+	//-seed n                            Block layout seed, default is the time.
+	//-record file                       Save the input of the session, see Replay.h.
+	//-play file                         Re-simulate a recording headless and exit.
+	//-bench-multiball [balls] [ticks]   Headless stress scene, no window.
+	//-bench-overlap [boxes] [iterations] SIMD against scalar box overlap.
+	//-bench-particles [count] [ticks]   SIMD against scalar and threaded particle update, -threads goes first.
+	//-bench-startup [levels]            Level start and first splinter timings.
+	//-bench-effects [hits] [explosions] [ticks]         Effects stress scene, no window. -threads and -lazy-particles go first.
+	//-bench-effects-render [hits] [explosions] [ticks]  Same scene drawn in the window, frame times included.
+	//-particle-layer                    Draw splitters through a cpu rasterized texture.
+	//-threads n                         Threads for the splitter update, default one per core.
+	//-lazy-particles                    Splitters in closed form, worked out only when drawn.
+	//-pipeline                          Simulate play on its own thread while the frame before is drawn.
+	//-pace vsync|cap|adaptive|off       Frame pacing, default vsync. See Pacer.h.
+	//-fps n                             Frame rate for -pace cap, default the display rate.
+	bool multiBall = false;
+	int  threads   = 0;
+	bool lazyParticles = false;
+	PaceMode paceMode = PACE_VSYNC;
+	int  paceFps  = 0;
+	int  benchHits = 0, benchExplosions = 0, benchTicks = 0; //-bench-effects-render
+	int  exitCode  = 0;
+	const char *recordPath = NULL;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-multiball") == 0)
+		{
+			multiBall = true;
+		}
+		else if (strcmp(argv[i], "-particle-layer") == 0)
+		{
+			useParticleLayer = true;
+		}
+		else if (strcmp(argv[i], "-lazy-particles") == 0)
+		{
+			lazyParticles = true;
+		}
+		else if (strcmp(argv[i], "-pipeline") == 0)
+		{
+			usePipeline = true;
+		}
+		else if (strcmp(argv[i], "-pace") == 0 && i + 1 < argc)
+		{
+			if (!PacerParseMode(argv[++i], &paceMode)) printf("Unknown pace mode %s, using %s.\n", argv[i], PacerModeName(paceMode));
+		}
+		else if (strcmp(argv[i], "-fps") == 0 && i + 1 < argc)
+		{
+			paceFps = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+		{
+			threads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+		{
+			seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "-record") == 0 && i + 1 < argc)
+		{
+			recordPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-play") == 0 && i + 1 < argc)
+		{
+			return ReplayPlayback(argv[i + 1]) ? 0 : 1;
+		}
+		else if (strcmp(argv[i], "-bench-multiball") == 0)
+		{
+			const int numBalls = i + 1 < argc ? atoi(argv[i + 1]) : 1000;
+			const int ticks    = i + 2 < argc ? atoi(argv[i + 2]) : 60 * 60;
+			return BenchMultiBall(numBalls, ticks) ? 0 : 1;
+		}
+		else if (strcmp(argv[i], "-bench-overlap") == 0)
+		{
+			const int numBoxes   = i + 1 < argc ? atoi(argv[i + 1]) : MAX_BLOCKS;
+			const int iterations = i + 2 < argc ? atoi(argv[i + 2]) : 10000;
+			return BenchOverlap(numBoxes, iterations) ? 0 : 1;
+		}
+		else if (strcmp(argv[i], "-bench-particles") == 0)
+		{
+			const int count = i + 1 < argc ? atoi(argv[i + 1]) : 100000;
+			const int ticks = i + 2 < argc ? atoi(argv[i + 2]) : 60 * 10;
+			return BenchParticles(count, ticks, threads) ? 0 : 1;
+		}
+		else if (strcmp(argv[i], "-bench-startup") == 0)
+		{
+			const int levels = i + 1 < argc ? atoi(argv[i + 1]) : 1000;
+			return BenchStartLevel(levels) ? 0 : 1;
+		}
+		else if (strcmp(argv[i], "-bench-effects") == 0 || strcmp(argv[i], "-bench-effects-render") == 0)
+		{
+			const int hits       = i + 1 < argc ? atoi(argv[i + 1]) : 100;
+			const int explosions = i + 2 < argc ? atoi(argv[i + 2]) : 10;
+			const int ticks      = i + 3 < argc ? atoi(argv[i + 3]) : 60 * 10;
+			if (strcmp(argv[i], "-bench-effects") == 0) return BenchEffects(hits, explosions, ticks, threads, lazyParticles) ? 0 : 1;
+
+			benchHits       = hits;
+			benchExplosions = explosions;
+			benchTicks      = ticks;
+			paceMode        = PACE_OFF; //Frame times are the work, not the display.
+			break;
+		}
+	}
+
+	//Every random number comes from this, -seed with it plays the same blocks and splitters again.
+	printf("Seed %u.\n", seed);
 
 	if (SDL_Init(SDL_INIT_EVERYTHING) == 0)
 	{
@@ -1447,9 +1482,23 @@ int main()
 		assert(sdlWindow);
 
 		//sdl2 renderer.
-		sdlRenderer = SDL_CreateRenderer(sdlWindow, -1, SDL_RENDERER_ACCELERATED);
+		sdlRenderer = SDL_CreateRenderer(sdlWindow, -1, SDL_RENDERER_ACCELERATED | (paceMode == PACE_VSYNC ? SDL_RENDERER_PRESENTVSYNC : 0));
 		assert(sdlRenderer);
 
+		//Frame pacing, at the display rate unless capped with -fps.
+		SDL_DisplayMode displayMode;
+		const int displayHz = SDL_GetWindowDisplayMode(sdlWindow, &displayMode) == 0 ? displayMode.refresh_rate : 0;
+
+		//Vsync pacing leaves the waiting to SDL_RenderPresent, a renderer without it would run unbounded.
+		SDL_RendererInfo rendererInfo;
+		if (paceMode == PACE_VSYNC && (SDL_GetRendererInfo(sdlRenderer, &rendererInfo) != 0 || !(rendererInfo.flags & SDL_RENDERER_PRESENTVSYNC)))
+		{
+			paceMode = PACE_FIXED;
+			paceFps  = displayHz;
+			printf("Renderer has no vsync, pacing with %s at the display rate.\n", PacerModeName(paceMode));
+		}
+		PacerInit(&pacer, paceMode, paceMode == PACE_FIXED && paceFps > 0 ? paceFps : displayHz);
+
 		//sdl2 image library
 		IMG_Init(IMG_INIT_PNG);
 
@@ -1491,6 +1540,14 @@ int main()
 		//Load sprites
 		spriteSheet = LoadTextureFromFile(sdlRenderer, "../res/images/breakout.png");
 
+		blockLayer = DBG_NEW BlockLayer;
+		if (!BlockLayerInit(blockLayer, sdlRenderer, spriteSheet))
+		{
+			printf("No render targets, blocks are drawn as sprites.\n");
+			delete blockLayer;
+			blockLayer = NULL;
+		}
+
 		//Load Sounds
 		explosionSound        = LoadSound("../res/sounds/explosion.ogg");
 		hooveringInMenuSound  = LoadSound("../res/sounds/hoovering_in_menu.ogg");
@@ -1500,12 +1557,6 @@ int main()
 		//Sound volumn
 		Mix_VolumeMusic(MIX_MAX_VOLUME / 8);
 
-		//Block splitter
-		blockSplitterColor[0] = { 135, 255, 255, 255 };
-		blockSplitterColor[1] = { 135, 63, 255, 255 };
-		blockSplitterColor[2] = { 255, 201, 165, 25 };
-		blockSplitterColor[3] = { 255, 30, 81, 255 };
-
 		//Block explosion
 		textureExplosion = LoadTextureFromFile(sdlRenderer, "../res/images/explosion.png");
 
@@ -1513,9 +1564,6 @@ int main()
 		scoreTextures.originColor = { 191, 66, 244, 255 };
 		scoreTextures.shadowColor = { 70, 40, 70, 255 };
 
-		//Level
-		score.level = 1;
-
 		//Next level
 		nextLevel.originColor = { 191, 66, 244, 255 };
 		nextLevel.shadowColor = { 70, 40, 70, 255 };
@@ -1558,19 +1606,56 @@ int main()
 
 		completedGame.backgroundTexture = LoadTextureFromFile(sdlRenderer, "../res/images/background_completed_game.png");
 
-		//paddle
-		paddle.maxWidth = PADDLE_FRAME_SIZE * 13;
-		paddle.maxVel = 10.0f;
+		//Paddle, ball, blocks and level.
+		SimInit(&sim);
+		SimSeed(&sim, seed);
+		sim.multiBall = multiBall;
+
+		if (recordPath && !ReplayBeginRecord(&replayRecorder, recordPath, &sim, seed))
+		{
+			printf("Failed to open %s for recording.\n", recordPath);
+		}
+
+		//Splitter, Explosion
+		EffectsInit(&effects);
+		EffectsSeed(&effects, seed);
+
+		JobsInit(&jobPool, threads);
+		effects.jobs = &jobPool;
+		effects.lazySplitters = lazyParticles;
+
+		if (useParticleLayer)
+		{
+			particleLayer = DBG_NEW ParticleLayer;
+			ParticleLayerClear(particleLayer);
+
+			particleLayerTexture = SDL_CreateTexture(sdlRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, PARTICLE_LAYER_WIDTH, PARTICLE_LAYER_HEIGHT);
+			assert(particleLayerTexture);
+			SDL_SetTextureBlendMode(particleLayerTexture, SDL_BLENDMODE_BLEND);
+			SDL_UpdateTexture(particleLayerTexture, NULL, particleLayer->pixels, PARTICLE_LAYER_WIDTH * sizeof(unsigned int));
+
+			for (int i = 0; i != BLOCK_TYPES; ++i)
+			{
+				particleLayerPalette[i] = ParticleLayerPixel(effects.blockSplitterColor[i]);
+			}
+		}
+
+		//Rewind
+		snapshots = DBG_NEW SnapshotRing;
+		SnapshotClear(snapshots);
 
-		//Ball	
-		ball.maxVel = Vec2(1.0f, 5.0f);
+		spriteBatch = DBG_NEW SpriteBatch;
+		SpriteBatchBeginFrame(spriteBatch);
 
-		//Blocks
-		blockMaxColumns = WINDOW_WIDTH % BLOCK_WIDTH;
-		blockMaxRows    = 4;
+		//Play frames, the second one is only built with -pipeline.
+		for (int i = 0; i != 2; ++i)
+		{
+			frames[i] = DBG_NEW FrameState;
+			FrameInit(frames[i]);
+		}
+		tickFrame = frames[0];
 
-		blockOffsetX = 10;
-		blockOffsetY = 3;
+		if (usePipeline) JobThreadInit(&simThread);
 
 		//set states
 		currentGameState = GAMESTATE_MENU;
@@ -1674,88 +1759,113 @@ int main()
 		menu.instructions[4].pos = { WINDOW_WIDTH / 2.0f - menu.instructions[4].size.x / 2.0f, menu.instructions[3].pos.y + menu.instructions[3].size.y + MENU_OFFSET_Y * 2 };
 
 
+		//Effects bench, replaces the game loop.
+		if (benchTicks > 0)
+		{
+			//Level 1 as a new game.
+			currentMenuState = MENUSTATE_NEW_GAME;
+			GameUpdate(TIME_STEP);
+
+			EffectsBench bench;
+			EffectsBenchBegin(&bench, &sim, &effects, benchHits, benchExplosions, benchTicks);
+
+			Timer frameTimer;
+			TimerInit(&frameTimer);
+
+			bool quit = false;
+			while (!quit && EffectsBenchTick(&bench))
+			{
+				while (SDL_PollEvent(&event))
+				{
+					if (event.type == SDL_QUIT) quit = true;
+					if (blockLayer) BlockLayerEvent(blockLayer, &event);
+				}
+
+				BuildFrame(frames[0], 1.0f);
+				GameRenderer(sdlRenderer, frames[0], &sim.blocks);
+
+				TimerTick(&frameTimer);
+				EffectsBenchFrame(&bench, TimerDeltaMs(&frameTimer));
+			}
+
+			exitCode = EffectsBenchEnd(&bench) ? 0 : 1;
+			currentMenuState = MENUSTATE_EXIT;
+		}
+
 		//GAME LOOP START!
 		while (currentMenuState != MENUSTATE_EXIT)
 		{
 			TimerTick(&updateTimer);
 			deltaTimeMs = TimerDeltaMs(&updateTimer);
 			accumulator += deltaTimeMs;
-			while (accumulator >= TIME_STEP)
+
+			bool drawn = true;
+			if (usePipeline && currentGameState == GAMESTATE_PLAY)
 			{
-				//Event poll
-				while (SDL_PollEvent(&event))
+				drawn = PipelinedPass(&accumulator);
+			}
+			else
+			{
+				//Left the pipeline, its last frame is never drawn so the block layer missed its hits.
+				if (frontFrameReady)
 				{
-					switch (event.type)
-					{
-						case SDL_KEYDOWN:
-							switch (event.key.keysym.sym)
-							{
-								case SDLK_LEFT:
-									paddle.dir = -1;
-									requestToMovePaddle = true;
-									break;
-
-								case SDLK_RIGHT:
-									paddle.dir = 1;
-									requestToMovePaddle = true;
-									break;
-
-								case SDLK_UP:
-									ball.vel = Vec2(0.0f, -ball.maxVel.y);
-									break;
-
-								case SDLK_ESCAPE:
-									if (currentGameState == GAMESTATE_PLAY)
-									{
-										currentGameState = GAMESTATE_MENU;
-										currentMenuState = MENUSTATE_NONE;
-									}
-									break;
-							}
-						break;
-						case SDL_KEYUP:
-							switch (event.key.keysym.sym)
-							{
-								case SDLK_LEFT:
-									requestToMovePaddle = false;
-									break;
-
-								case SDLK_RIGHT:
-									requestToMovePaddle = false;
-									break;
-							}
-							break;
-						case SDL_MOUSEBUTTONDOWN:
-							if (event.button.clicks == SDL_BUTTON_LEFT) isLeftMouseBtnClicked = true;
-							break;
-						case SDL_MOUSEBUTTONUP:
-							if (isLeftMouseBtnClicked) isLeftMouseBtnClicked = false;
-							break;
-						case SDL_QUIT:
-							currentMenuState = MENUSTATE_EXIT;
-							break;
-					}
+					frontFrameReady = false;
+					FrameClearBlocks(frames[0]);
+					FrameClearBlocks(frames[1]);
+					tickFrame = frames[0];
+					if (blockLayer) BlockLayerInvalidate(blockLayer);
+				}
+
+				int ticks = 0;
+				while (accumulator >= TIME_STEP)
+				{
+					//Event poll
+					while (SDL_PollEvent(&event)) HandleEvent(&event);
+
+					accumulator -= TIME_STEP; 
+					++ticks;
+
+					//Do Update
+					GameUpdate(TIME_STEP); // 60 fps.
 				}
-				
-				accumulator -= TIME_STEP; 
 
-				//Do Update
-				GameUpdate(TIME_STEP); // 60 fps.
+				//Do renderer, between the last two ticks. Only play moves between ticks, the rest would be the same frame again.
+				drawn = ticks > 0 || currentGameState == GAMESTATE_PLAY || pacer.mode == PACE_OFF;
+				if (drawn)
+				{
+					if (currentGameState == GAMESTATE_PLAY) BuildFrame(frames[0], accumulator / TIME_STEP);
+					GameRenderer(sdlRenderer, frames[0], &sim.blocks);
+				}
 			}
 
+			if (drawn) PacerFrameEnd(&pacer);
+			else PacerIdle(&pacer, TIME_STEP - accumulator);
+
 			TimerTick(&renderTimer);
 
-			//Do renderer
-			GameRenderer(sdlRenderer);
+			drawStats.timeToTitle -= TimerDeltaMs(&renderTimer);
+			if (drawStats.timeToTitle <= 0)
+			{
+				drawStats.timeToTitle = DRAW_STATS_INTERVAL;
+
+				char title[MAX_TEXT_LENGTH * 2];
+				snprintf(title, sizeof(title), "BreakOut - %d draw calls, %d texture switches, %d particles, %d missed frames", drawStats.lastCalls, drawStats.lastTextureSwitches, drawStats.particles, pacer.missed);
+				SDL_SetWindowTitle(sdlWindow, title);
+			}
 		}
 
 		//GAME LOOP END!
+		printf("Pacer: %s at %.1f Hz, %d frames, %d missed deadlines.\n", PacerModeName(pacer.mode), 1000.0 / pacer.intervalMs, pacer.frames, pacer.missed);
 
 		//Destroy
 		//Play textures
 		//Play: block, player, ball
 		SDL_DestroyTexture(spriteSheet);
 
+		if (blockLayer) BlockLayerFree(blockLayer);
+		delete blockLayer;
+		blockLayer = NULL;
+
 		//Play: game over
 		SDL_DestroyTexture(gameOver.originTexture);
 		SDL_DestroyTexture(gameOver.shadowTexture);
@@ -1778,16 +1888,28 @@ int main()
 		SDL_DestroyTexture(textureExplosion);
 		textureExplosion = NULL;
 
+		//Play: particle layer
+		if (particleLayerTexture) SDL_DestroyTexture(particleLayerTexture);
+		particleLayerTexture = NULL;
+
+		delete particleLayer;
+		particleLayer = NULL;
+
 		//Play: backgrounds
 		SDL_DestroyTexture(nextLevel.backgroundTexture);
 		SDL_DestroyTexture(completedGame.backgroundTexture);
 		SDL_DestroyTexture(gameOver.backgroundTexture);
-		SDL_DestroyTexture(currentBackgroundLevelTexture);
 		nextLevel.backgroundTexture     = NULL;
 		completedGame.backgroundTexture = NULL;
 		gameOver.backgroundTexture      = NULL;
 		currentBackgroundLevelTexture   = NULL;
 
+		for (int i = 0; i != LEVEL_BACKGROUNDS; ++i)
+		{
+			if (levelBackgroundTextures[i]) SDL_DestroyTexture(levelBackgroundTextures[i]);
+			levelBackgroundTextures[i] = NULL;
+		}
+
 		//Play: level
 		SDL_DestroyTexture(scoreTextures.levelShadowTexture);
 		SDL_DestroyTexture(scoreTextures.levelTexture);
@@ -1869,8 +1991,24 @@ int main()
 		SDL_DestroyWindow(sdlWindow);
 		sdlWindow = NULL;
 
-		delete[] blocks;
-		blocks = NULL;
+		if (usePipeline) JobThreadFree(&simThread);
+		EffectsFree(&effects);
+		JobsFree(&jobPool);
+
+		delete snapshots;
+		snapshots = NULL;
+
+		delete spriteBatch;
+		spriteBatch = NULL;
+
+		for (int i = 0; i != 2; ++i)
+		{
+			FrameFree(frames[i]);
+			delete frames[i];
+			frames[i] = NULL;
+		}
+
+		ReplayEndRecord(&replayRecorder, &sim);
 
 		//Close mixer
 		Mix_CloseAudio();
@@ -1886,5 +2024,5 @@ int main()
 		SDL_Quit();
 	}
 
-	return 0;
+	return exitCode;
 }
\ No newline at end of file